@@ -103,6 +103,15 @@ int mdr_device_process_by_availability(mdr_device_t*,
                                        bool readable,
                                        bool writable);
 
+/*
+ * Set the priority of the requests made by the device functions from now
+ * on, e.g. background for periodic polling or interactive for changes
+ * made by the user, see `mdr_packetconn_set_request_priority`.
+ *
+ * Returns -1 and sets errno to EINVAL if the priority is invalid.
+ */
+int mdr_device_set_request_priority(mdr_device_t*, mdr_packetconn_priority_t);
+
 /*
  * Get which functions are supported by this device.
  *
@@ -527,6 +536,10 @@ int mdr_device_setting_enable_auto_power_off(
 /*
  * Get the key (buttons) names, their type, default preset and availabe presets.
  *
+ * The keys are only valid during the call, their presets and actions are
+ * laid out as described for
+ * `mdr_packet_system_capability_assignable_settings_t`.
+ *
  * This function can only be called if `assignable_settings` is true
  * in the device's supported function.
  * If is not supported, -1 is returned and errno is set to
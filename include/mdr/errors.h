@@ -30,5 +30,6 @@
 #define MDR_E_NO_REPLY          -5
 #define MDR_E_CLOSED            -6
 #define MDR_E_NOT_SUPPORTED     -7
+#define MDR_E_SUPERSEDED        -8
 
 #endif /* __MDR_ERRORS_H__ */
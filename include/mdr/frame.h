@@ -111,4 +111,49 @@ uint8_t* mdr_frame_checksum(mdr_frame_t*);
  */
 uint8_t mdr_frame_compute_checksum(mdr_frame_t*);
 
+/*
+ * A pool of frames which recycles their storage.
+ *
+ * Frames are kept in size classes so a released frame can be handed out
+ * again for any payload that fits the same class. Frames acquired from a
+ * pool are allocated using malloc, so they may also be freed with `free`.
+ *
+ * A pool is not thread-safe.
+ */
+typedef struct mdr_frame_pool mdr_frame_pool_t;
+
+/*
+ * Create a new, empty frame pool.
+ *
+ * Returns NULL and sets errno on error.
+ */
+mdr_frame_pool_t* mdr_frame_pool_new();
+
+/*
+ * Free a frame pool and all frames held by it.
+ *
+ * Frames which have been acquired but not released are not affected.
+ */
+void mdr_frame_pool_free(mdr_frame_pool_t*);
+
+/*
+ * Get a frame with room for `payload_length` bytes of payload,
+ * `payload_length` is set but the rest of the frame is uninitialized.
+ *
+ * The pool may be NULL, in which case the frame is always newly allocated.
+ *
+ * Returns NULL and sets errno on error.
+ */
+mdr_frame_t* mdr_frame_pool_acquire(mdr_frame_pool_t*, uint32_t payload_length);
+
+/*
+ * Give a frame back to the pool for reuse, or free it if the pool
+ * is full or NULL.
+ *
+ * The frame may be any frame allocated using malloc, e.g. one acquired
+ * from any pool or one returned by `mdr_frame_dup`. It is pooled by the
+ * size of its allocation, whatever its `payload_length`.
+ */
+void mdr_frame_pool_release(mdr_frame_pool_t*, mdr_frame_t*);
+
 #endif /* __MDR_FRAME_H__ */
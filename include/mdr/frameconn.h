@@ -24,10 +24,12 @@
 #define __MDR_FRAMECONN_H__
 
 #include "mdr/frame.h"
+#include "mdr/transport.h"
 
 #include <bluetooth/bluetooth.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define MDR_SERVICE_UUID "96CC203E-5068-46AD-B32D-E316F5E069BA"
@@ -56,10 +58,31 @@ mdr_frameconn_t* mdr_frameconn_connect(bdaddr_t addr, uint8_t channel);
 mdr_frameconn_t* mdr_frameconn_new(int sock);
 
 /*
- * Get the socket associated with this frame-connection.
+ * Create a frame-connection which reads and writes through a transport.
+ *
+ * The frame-connection takes ownership of the transport on success.
+ *
+ * Returns NULL and sets errno on error.
+ */
+mdr_frameconn_t* mdr_frameconn_new_from_transport(mdr_transport_t*);
+
+/*
+ * Get the socket associated with this frame-connection,
+ * or the file descriptor to poll for its transport.
+ *
+ * Returns -1 if the transport has nothing to poll.
  */
 int mdr_frameconn_get_socket(mdr_frameconn_t*);
 
+/*
+ * Get the frame pool received frames are acquired from.
+ *
+ * Frames returned by `mdr_frameconn_read_frame` may be released to it
+ * once they are no longer needed so their storage is reused.
+ * The pool is freed along with the frame-connection.
+ */
+mdr_frame_pool_t* mdr_frameconn_frame_pool(mdr_frameconn_t*);
+
 /*
  * Checks if the frameconn wants to write data.
  *
@@ -68,6 +91,48 @@ int mdr_frameconn_get_socket(mdr_frameconn_t*);
  */
 bool mdr_frameconn_waiting_write(mdr_frameconn_t*);
 
+/*
+ * Set the largest size the read and write buffers may grow to,
+ * which must be a power of two between 512 B and 1 MiB (8 KiB by default).
+ *
+ * This also limits the size of frames which can be sent and received,
+ * larger received frames are dropped and sending one fails with EMSGSIZE.
+ *
+ * Returns -1 and sets errno to EINVAL if the limit is invalid.
+ */
+int mdr_frameconn_set_buffer_limit(mdr_frameconn_t*, size_t limit);
+
+/*
+ * Checks if the frameconn currently holds any I/O buffers.
+ *
+ * Buffers are allocated when first needed.
+ */
+bool mdr_frameconn_has_buffers(mdr_frameconn_t*);
+
+/*
+ * Give the I/O buffers back to a slab shared by all connections
+ * if they are empty, e.g. after the connection has been idle for a while.
+ *
+ * They are allocated again when next needed.
+ */
+void mdr_frameconn_release_buffers(mdr_frameconn_t*);
+
+/*
+ * Checks if the frameconn has read bytes which have not been decoded yet,
+ * e.g. because `mdr_frameconn_read_frames` returned `max` frames, or if its
+ * transport holds input it has already received.
+ *
+ * Such bytes won't make the underlying socket readable, so they should be
+ * processed without waiting for it.
+ */
+bool mdr_frameconn_waiting_read(mdr_frameconn_t*);
+
+/*
+ * Get the number of received frames which have been dropped
+ * because they were corrupt, e.g. had a bad checksum or ended early.
+ */
+size_t mdr_frameconn_bad_frames(mdr_frameconn_t*);
+
 /*
  * Close a frame-connection and free any associated resources.
  */
@@ -82,6 +147,9 @@ void mdr_frameconn_free(mdr_frameconn_t*);
 /*
  * Try to flush any buffered writes.
  *
+ * All queued frames are written with a single `writev` unless the socket
+ * only accepts part of them.
+ *
  * Returns 0 on success, returns -1 and sets errno on error.
  */
 int mdr_frameconn_flush_write(mdr_frameconn_t*);
@@ -89,19 +157,80 @@ int mdr_frameconn_flush_write(mdr_frameconn_t*);
 /*
  * Read a single frame from the connection.
  *
- * The returned frame is allocated using malloc and is caller-freed.
+ * The returned frame is allocated using malloc and is caller-freed,
+ * either with `free` or by releasing it to `mdr_frameconn_frame_pool`.
+ * Frames with a bad checksum are dropped and never returned.
  *
- * Returns NULL and sets errno on error.
+ * Returns NULL and sets errno on error,
+ * errno is set to MDR_E_CLOSED if the remote end closed the connection.
  */
 mdr_frame_t* mdr_frameconn_read_frame(mdr_frameconn_t*);
 
+/*
+ * Read up to `max` frames from the connection into `frames`.
+ *
+ * Every complete frame already buffered is returned without touching the
+ * socket. The socket is only read if no frame is buffered, in which case
+ * this behaves like `mdr_frameconn_read_frame` and then also returns any
+ * further frames the same read produced.
+ *
+ * The returned frames are allocated using malloc and are caller-freed.
+ *
+ * Returns the number of frames read,
+ * returns -1 and sets errno if no frame could be read.
+ */
+int mdr_frameconn_read_frames(mdr_frameconn_t*, mdr_frame_t** frames, int max);
+
+/*
+ * Like `mdr_frameconn_read_frames`, but only decodes bytes which have
+ * already been read, or received by the transport, and never waits for
+ * the socket.
+ *
+ * Returns the number of frames read, returns -1 and sets errno if no
+ * frame could be read, EAGAIN if no complete frame is buffered.
+ */
+int mdr_frameconn_read_buffered_frames(mdr_frameconn_t*,
+                                       mdr_frame_t** frames,
+                                       int max);
+
+/*
+ * Queue a frame to be written by the next call to
+ * `mdr_frameconn_flush_write` without writing anything to the socket,
+ * unless that is needed to make room for it.
+ *
+ * This allows several frames to be sent with a single system call.
+ * The frame is escaped into the connection's write buffer and is not freed.
+ *
+ * Returns
+ *   -1 on error and sets errno, EWOULDBLOCK if the write buffer is full
+ *    0 on success
+ */
+int mdr_frameconn_queue_frame(mdr_frameconn_t*, mdr_frame_t*);
+
+/*
+ * Queue bytes which already are one or more complete, escaped frames,
+ * e.g. encoded by `mdr_packet_encode_wire`, like `mdr_frameconn_queue_frame`.
+ *
+ * The bytes are copied into the connection's write buffer as they are.
+ *
+ * Returns
+ *   -1 on error and sets errno, EWOULDBLOCK if the write buffer is full
+ *    0 on success
+ */
+int mdr_frameconn_queue_escaped(mdr_frameconn_t*,
+                                const uint8_t* bytes,
+                                size_t len);
+
 /*
  * Write a frame to this connection.
  *
- * The frame must be allocated using malloc and is callee-freed.
+ * The frame is escaped into the connection's write buffer and is
+ * not freed, it may be written again (e.g. when re-sending).
+ * If the socket would block the frame is kept in the write buffer
+ * and sent by a later call to `mdr_frameconn_flush_write`.
  *
  * Returns
- *   -1 on error and sets errno
+ *   -1 on error and sets errno, EWOULDBLOCK if the write buffer is full
  *    0 on success
  */
 int mdr_frameconn_write_frame(mdr_frameconn_t*, mdr_frame_t*);
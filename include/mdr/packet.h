@@ -27,6 +27,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef enum
 {
@@ -265,6 +266,12 @@ typedef struct
 }
 mdr_packet_t;
 
+/*
+ * Free a packet returned by `mdr_packet_from_frame`.
+ *
+ * Decoded packets are a single allocation, including any strings
+ * and arrays they point to.
+ */
 void mdr_packet_free(mdr_packet_t*);
 
 /*
@@ -274,6 +281,36 @@ void mdr_packet_free(mdr_packet_t*);
  */
 mdr_packet_t* mdr_packet_from_frame(mdr_frame_t*);
 
+/*
+ * Get the number of bytes needed to decode the packet in the given frame
+ * with `mdr_packet_from_frame_into`.
+ *
+ * Returns 0 and sets errno if the frame does not contain a valid
+ * MDR packet.
+ */
+size_t mdr_packet_decoded_size(mdr_frame_t*);
+
+/*
+ * Read an MDR packet from the given frame into `buf` without allocating,
+ * `buf` must be aligned like memory returned by malloc.
+ *
+ * The packet and any strings and arrays it points to are placed in `buf`,
+ * it must not be freed with `mdr_packet_free`.
+ *
+ * Returns NULL and sets errno to ENOBUFS if `size` is too small,
+ * see `mdr_packet_decoded_size`.
+ */
+mdr_packet_t* mdr_packet_from_frame_into(mdr_frame_t*, void* buf, size_t size);
+
+/*
+ * Same as `mdr_packet_from_frame_into` except strings are not copied,
+ * they point into the payload of the frame instead.
+ *
+ * The packet is only valid as long as both the frame and `buf` are,
+ * it never needs more than `mdr_packet_decoded_size` bytes.
+ */
+mdr_packet_t* mdr_packet_view_from_frame(mdr_frame_t*, void* buf, size_t size);
+
 /*
  * Encode an MDR packet into a frame.
  *
@@ -281,4 +318,127 @@ mdr_packet_t* mdr_packet_from_frame(mdr_frame_t*);
  */
 mdr_frame_t* mdr_packet_to_frame(mdr_packet_t*);
 
+/*
+ * Encode an MDR packet into a frame acquired from `pool`.
+ *
+ * The frame should be given back using `mdr_frame_pool_release`.
+ *
+ * May return NULL with errno set to ENOMEM.
+ */
+mdr_frame_t* mdr_packet_to_frame_from_pool(mdr_packet_t*, mdr_frame_pool_t*);
+
+/*
+ * Get the exact payload length of the frame an MDR packet encodes into.
+ *
+ * Returns 0 and sets errno if the packet can't be encoded.
+ */
+size_t mdr_packet_encoded_size(mdr_packet_t*);
+
+/*
+ * The largest number of bytes a packet with an encoded size of
+ * `payload_length` can occupy on the wire, when every byte is escaped.
+ */
+#define MDR_PACKET_WIRE_MAX_LEN(payload_length) \
+    (2 + 2 * (MDR_FRAME_EMPTY_LEN + (size_t) (payload_length)))
+
+/*
+ * Encode an MDR packet into a complete, escaped frame as it is sent on
+ * the wire, start and end bytes included, in a single pass into `buf`.
+ *
+ * `MDR_PACKET_WIRE_MAX_LEN(mdr_packet_encoded_size(packet))` bytes are
+ * always enough.
+ *
+ * Returns the number of bytes written,
+ * returns 0 and sets errno on error, ENOBUFS if `size` is too small.
+ */
+size_t mdr_packet_encode_wire(mdr_packet_t*,
+                              uint8_t sequence_id,
+                              uint8_t* buf,
+                              size_t size);
+
+/*
+ * Same as `mdr_packet_encode_wire` for an already encoded payload of
+ * `length` bytes, which is copied as it is.
+ *
+ * `MDR_PACKET_WIRE_MAX_LEN(length)` bytes are always enough.
+ *
+ * Returns the number of bytes written,
+ * returns 0 and sets errno on error, ENOBUFS if `size` is too small.
+ */
+size_t mdr_packet_encode_wire_payload(const uint8_t* payload,
+                                      size_t length,
+                                      uint8_t sequence_id,
+                                      uint8_t* buf,
+                                      size_t size);
+
+/*
+ * Change the sequence id (0 or 1) of a frame of `len` bytes encoded by
+ * `mdr_packet_encode_wire`, updating its checksum in place.
+ *
+ * The checksum may need to be escaped, growing the frame by one byte,
+ * so `wire` must have room for `len + 1` bytes.
+ *
+ * Returns the new length of the frame,
+ * returns 0 and sets errno to EINVAL if it isn't such a frame.
+ */
+size_t mdr_packet_wire_set_sequence_id(uint8_t* wire,
+                                       size_t len,
+                                       uint8_t sequence_id);
+
+/*
+ * Check if packets of `type` are GET requests, which only query the
+ * device and can be sent any number of times to the same effect.
+ */
+bool mdr_packet_type_is_get(mdr_packet_type_t type);
+
+/*
+ * Check if packets of `type` are SET requests, which change the setting
+ * identified by the type and the "extra" parameter of the packet.
+ * Only the last of several such requests for the same setting matters.
+ */
+bool mdr_packet_type_is_set(mdr_packet_type_t type);
+
+/*
+ * Check if packets of `type` have an "extra" parameter
+ * checked by `mdr_packet_matches`.
+ */
+bool mdr_packet_type_has_extra(mdr_packet_type_t type);
+
+/*
+ * Get the "extra" parameter of a packet checked by `mdr_packet_matches`,
+ * 0 for types without one.
+ */
+uint8_t mdr_packet_extra(mdr_packet_t*);
+
+/*
+ * Check if a packet is of `type` and, for types which have one,
+ * if its "extra" parameter (usually the inquired type) is `extra`.
+ */
+bool mdr_packet_matches(mdr_packet_t*, mdr_packet_type_t type, uint8_t extra);
+
+/*
+ * Check if a frame holds a packet which `mdr_packet_matches` `type` and
+ * `extra`, looking only at the type byte and the byte of the "extra"
+ * parameter without decoding the packet.
+ *
+ * For types without an extra parameter, including types which can't be
+ * decoded, only the type is checked. The rest of the packet may still
+ * fail to decode.
+ */
+bool mdr_packet_frame_matches(mdr_frame_t*,
+                              mdr_packet_type_t type,
+                              uint8_t extra);
+
+/*
+ * Get the type and "extra" parameter (0 for types without one) of the
+ * packet held by a frame without decoding it, the values
+ * `mdr_packet_frame_matches` checks.
+ *
+ * Returns false if the frame doesn't hold an MDR packet
+ * or is too short to hold its "extra" parameter.
+ */
+bool mdr_packet_frame_peek(mdr_frame_t*,
+                           mdr_packet_type_t* type,
+                           uint8_t* extra);
+
 #endif /* __MDR_PACKET_H__ */
@@ -316,6 +316,13 @@ typedef struct
 }
 mdr_packet_system_assignable_settings_capability_key_t;
 
+/*
+ * In a decoded packet the presets of every key are stored contiguously in
+ * key order, in a single array starting at the `capability_presets` of the
+ * first key, and the actions of every preset likewise. The tree can be
+ * traversed as flat arrays, e.g. the index of the first preset of a key is
+ * `key->capability_presets - capability_keys[0].capability_presets`.
+ */
 typedef struct
 {
     uint8_t num_capability_keys;
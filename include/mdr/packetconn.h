@@ -89,9 +89,75 @@ mdr_poll_info mdr_packetconn_poll_info(mdr_packetconn_t*);
  */
 int mdr_packetconn_process(mdr_packetconn_t*);
 
+/*
+ * Set the maximum number of received frames handled by a single call to
+ * `mdr_packetconn_process`, between 1 and 64 (16 by default).
+ *
+ * All frames produced by one read from the socket are handled in the same
+ * call up to this limit, any remaining frames are left for the next call.
+ *
+ * Returns -1 and sets errno to EINVAL if the budget is out of range.
+ */
+int mdr_packetconn_set_frame_budget(mdr_packetconn_t*, int budget);
+
+/*
+ * Set the time in milliseconds to wait for a request to be ACK'd before
+ * sending it again, and for the reply once it has been ACK'd.
+ *
+ * By default, or if a timeout is 0, it is estimated from the round trips
+ * measured on the connection, starting at 1 s and staying within
+ * 0.2 s to 8 s, and doubled every time a request is sent again.
+ *
+ * Returns -1 and sets errno to EINVAL if a timeout is negative.
+ */
+int mdr_packetconn_set_timeouts(mdr_packetconn_t*,
+                                int ack_timeout,
+                                int reply_timeout);
+
+/*
+ * Set the number of times a request is sent without being ACK'd before
+ * failing with MDR_E_NO_ACK, between 1 and 16 (3 by default).
+ *
+ * Returns -1 and sets errno to EINVAL if `tries` is out of range.
+ */
+int mdr_packetconn_set_max_tries(mdr_packetconn_t*, int tries);
+
+/*
+ * The priority of a request.
+ *
+ * Queued requests are sent highest priority first, and in the order they
+ * were made within a priority. The request being sent is never preempted,
+ * not even by a request of a higher priority.
+ */
+typedef enum
+{
+    MDR_PACKETCONN_PRIORITY_INTERACTIVE = 0,
+    MDR_PACKETCONN_PRIORITY_NORMAL      = 1,
+    MDR_PACKETCONN_PRIORITY_BACKGROUND  = 2,
+}
+mdr_packetconn_priority_t;
+
+/*
+ * Set the priority of the requests made on the connection from now on,
+ * `MDR_PACKETCONN_PRIORITY_NORMAL` by default.
+ *
+ * A request coalesced with, or replacing, a queued request of a lower
+ * priority raises the priority of the queued request.
+ *
+ * Returns -1 and sets errno to EINVAL if the priority is invalid.
+ */
+int mdr_packetconn_set_request_priority(mdr_packetconn_t*,
+                                        mdr_packetconn_priority_t);
+
 /*
  * Same as `mdr_packetconn_process` except only attempt to read/write if
  * `readable`/`writable` is true, respectively.
+ *
+ * Frames already buffered, e.g. left over by the frame budget, are handled
+ * whether or not the socket is readable.
+ *
+ * Frames produced during the call, ACKs as well as requests, are queued
+ * and flushed together at the end of it.
  */
 int mdr_packetconn_process_by_availability(mdr_packetconn_t*,
                                             bool readable,
@@ -109,6 +175,18 @@ typedef void (*mdr_packetconn_result_callback)(mdr_packet_t*, void* user_data);
  */
 typedef void (*mdr_packetconn_error_callback)(void* user_data);
 
+/*
+ * Called with the payload of a matching packet for raw requests and
+ * subscriptions, starting with the packet type byte.
+ *
+ * The payload is borrowed from the received frame and is only valid
+ * during the call. It is NULL, with a `length` of 0, for raw requests
+ * which only expect an ACK.
+ */
+typedef void (*mdr_packetconn_raw_result_callback)(const uint8_t* payload,
+                                                   size_t length,
+                                                   void* user_data);
+
 /*
  * A match pattern for reply packets.
  *
@@ -134,6 +212,16 @@ mdr_packetconn_reply_specifier_t;
  *
  * The reply pointer is a handle to the request which can be passed to
  * `mdr_packetconn_wait_for_result` to finish a call synchronously.
+ *
+ * A GET request (see `mdr_packet_type_is_get`) identical to one already
+ * queued, expecting the same reply, is coalesced with it. No new request
+ * is sent, the callbacks are called along with those of the queued
+ * request, which is the handle returned.
+ *
+ * A SET request (see `mdr_packet_type_is_set`) replaces a queued SET
+ * request for the same setting which hasn't been sent yet, taking its
+ * place in the queue and its handle. The error callback of the replaced
+ * request is called with errno set to `MDR_E_SUPERSEDED`.
  */
 void* mdr_packetconn_make_request(
         mdr_packetconn_t*,
@@ -143,6 +231,62 @@ void* mdr_packetconn_make_request(
         mdr_packetconn_error_callback error_callback,
         void* user_data);
 
+/*
+ * A request packet encoded once which can be sent any number of times,
+ * e.g. a GET request which is made often.
+ *
+ * Requests made from a template share its encoded frame, only the
+ * sequence id and checksum are patched when it's sent.
+ */
+typedef struct mdr_packetconn_template mdr_packetconn_template_t;
+
+/*
+ * Create a template of a request packet.
+ *
+ * Only small packets, such as GET requests, can be templates.
+ *
+ * Returns NULL and sets errno on error,
+ * ENOBUFS if the packet is too large.
+ */
+mdr_packetconn_template_t* mdr_packetconn_template_new(mdr_packet_t*);
+
+/*
+ * Free a template, no request made from it may still be pending.
+ */
+void mdr_packetconn_template_free(mdr_packetconn_template_t*);
+
+/*
+ * Send a request from a template, like `mdr_packetconn_make_request`.
+ *
+ * Returns NULL and sets errno on error.
+ */
+void* mdr_packetconn_make_request_from_template(
+        mdr_packetconn_t*,
+        const mdr_packetconn_template_t*,
+        mdr_packetconn_reply_specifier_t,
+        mdr_packetconn_result_callback result_callback,
+        mdr_packetconn_error_callback error_callback,
+        void* user_data);
+
+/*
+ * Send a request with an already encoded payload of `length` bytes,
+ * starting with the packet type byte, and have the payload of the reply
+ * passed to `result_callback` without decoding it.
+ *
+ * The packet type doesn't have to be one libmdr can decode,
+ * replies to such types are matched on the type alone.
+ *
+ * Returns NULL and sets errno on error.
+ */
+void* mdr_packetconn_make_raw_request(
+        mdr_packetconn_t*,
+        const uint8_t* payload,
+        size_t length,
+        mdr_packetconn_reply_specifier_t,
+        mdr_packetconn_raw_result_callback result_callback,
+        mdr_packetconn_error_callback error_callback,
+        void* user_data);
+
 
 /*
  * Subscribe to packets of a certain type and, for some types, extra type.
@@ -152,6 +296,11 @@ void* mdr_packetconn_make_request(
  * `mdr_packetconn_remove_subscription` to remove a subscription.
  * Subcriptions are automatically removed when `mdr_packetconn_close` or
  * `mdr_packetconn_free` is called.
+ *
+ * Subscriptions are indexed by packet type and extra type, finding those
+ * matching a received packet doesn't depend on the number of other
+ * subscriptions. Matching subscriptions are called in the order they
+ * were made.
  */
 void* mdr_packetconn_subscribe(
         mdr_packetconn_t*,
@@ -159,6 +308,20 @@ void* mdr_packetconn_subscribe(
         mdr_packetconn_result_callback callback,
         void* user_data);
 
+/*
+ * Same as `mdr_packetconn_subscribe` except the payload of matching
+ * packets is passed to `callback` without decoding them,
+ * see `mdr_packetconn_make_raw_request`.
+ *
+ * Raw subscriptions are called before any packet subscriptions
+ * matching the same packet.
+ */
+void* mdr_packetconn_subscribe_raw(
+        mdr_packetconn_t*,
+        mdr_packetconn_reply_specifier_t,
+        mdr_packetconn_raw_result_callback callback,
+        void* user_data);
+
 /*
  * Wait for the completion of a previously made request.
  *
@@ -180,6 +343,9 @@ void* mdr_packetconn_wait_for_result(mdr_packetconn_t*, void* handle);
 /*
  * Removes a previously registered subscription (`mdr_device_subscribe`.. call)
  * using the handle that that function returned.
+ *
+ * The handle must be of a subscription on this connection which hasn't been
+ * removed, a subscription may remove itself from its callback.
  */
 void mdr_packetconn_remove_subscription(mdr_packetconn_t*, void* handle);
 
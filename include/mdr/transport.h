@@ -0,0 +1,138 @@
+/*
+ * libmdr - MDR protocol library
+ *
+ *  Copyright (C) 2021 Andreas Olofsson
+ *
+ *
+ * This file is part of libmdr.
+ *
+ * libmdr is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libmdr is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libmdr. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __MDR_TRANSPORT_H__
+#define __MDR_TRANSPORT_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/*
+ * The operations a transport implements.
+ *
+ * `read` and `writev` behave like the system calls of the same name,
+ * returning -1 and setting errno on error (EAGAIN if they would block)
+ * and `read` returning 0 once the remote end has closed the transport.
+ */
+typedef struct
+{
+    ssize_t (*read)(void* data, void* buf, size_t len);
+    ssize_t (*writev)(void* data, const struct iovec* iov, int iovcnt);
+
+    /*
+     * Get a file descriptor which can be polled for the transport
+     * becoming readable or writable, or -1 if there is none in which case
+     * the transport should be considered always ready.
+     */
+    int (*poll_fd)(void* data);
+
+    /*
+     * Check if `read` would return something, bytes, the end of the stream
+     * or an error, which won't make the poll fd readable because the
+     * transport has already received it. May be NULL if that never happens.
+     */
+    bool (*has_buffered_input)(void* data);
+
+    /*
+     * Close the transport and free `data`.
+     */
+    void (*close)(void* data);
+
+    /*
+     * Free `data` without closing the underlying channel, may be NULL if
+     * that's not possible, in which case the transport is closed instead.
+     */
+    void (*free)(void* data);
+}
+mdr_transport_ops_t;
+
+/*
+ * A byte-stream transport frame-connections read from and write to.
+ *
+ * See `mdr_frameconn_new_from_transport`.
+ */
+typedef struct mdr_transport mdr_transport_t;
+
+/*
+ * Create a transport from a set of operations.
+ *
+ * `data` is passed to every operation.
+ *
+ * Returns NULL and sets errno on error.
+ */
+mdr_transport_t* mdr_transport_new(const mdr_transport_ops_t* ops, void* data);
+
+/*
+ * Create a transport which reads from and writes to a file descriptor,
+ * e.g. a connected socket.
+ *
+ * Returns NULL and sets errno on error.
+ */
+mdr_transport_t* mdr_transport_new_fd(int fd);
+
+/*
+ * Create a pair of connected transports backed by a UNIX socketpair.
+ *
+ * Returns -1 and sets errno on error.
+ */
+int mdr_transport_new_socketpair(mdr_transport_t* transports[2]);
+
+/*
+ * Create a pair of connected in-memory transports,
+ * bytes written to one can be read from the other.
+ *
+ * The transports never block, reading when there is nothing to read
+ * fails with EAGAIN. They have no file descriptor to poll and are not
+ * thread-safe.
+ *
+ * Returns -1 and sets errno on error.
+ */
+int mdr_transport_new_loopback(mdr_transport_t* transports[2]);
+
+ssize_t mdr_transport_read(mdr_transport_t*, void* buf, size_t len);
+
+ssize_t mdr_transport_writev(mdr_transport_t*,
+                             const struct iovec* iov,
+                             int iovcnt);
+
+int mdr_transport_poll_fd(mdr_transport_t*);
+
+/*
+ * Check if the transport has received input which should be read without
+ * waiting for its poll fd, see `mdr_transport_ops_t`.
+ */
+bool mdr_transport_has_buffered_input(mdr_transport_t*);
+
+/*
+ * Close a transport and free any associated resources.
+ */
+void mdr_transport_close(mdr_transport_t*);
+
+/*
+ * Free any resources allocated by the transport without closing it,
+ * e.g. without closing the file descriptor of an fd transport.
+ */
+void mdr_transport_free(mdr_transport_t*);
+
+#endif /* __MDR_TRANSPORT_H__ */
@@ -0,0 +1,93 @@
+/*
+ * libmdr - MDR protocol library
+ *
+ *  Copyright (C) 2021 Andreas Olofsson
+ *
+ *
+ * This file is part of libmdr.
+ *
+ * libmdr is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libmdr is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libmdr. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __MDR_URING_H__
+#define __MDR_URING_H__
+
+#include "mdr/transport.h"
+
+/*
+ * An io_uring instance shared by any number of connections.
+ *
+ * Every socket wrapped with `mdr_uring_new_transport` keeps a multishot
+ * receive posted on the ring, received bytes are buffered per transport.
+ * Writes are queued as sends and only submitted to the kernel, together
+ * with any other queued sends, by `mdr_uring_submit`.
+ *
+ * A typical event loop polls `mdr_uring_get_fd` (this is also the fd
+ * returned by `mdr_frameconn_get_socket` for such connections), processes
+ * every connection and then calls `mdr_uring_submit` once. Completions
+ * are handled for all transports at once, so the next poll must not wait
+ * while any connection still has buffered input, see
+ * `mdr_frameconn_waiting_read` and `mdr_packetconn_poll_info`.
+ *
+ * Requires Linux 6.0 or later, the ring and its transports are
+ * not thread-safe.
+ */
+typedef struct mdr_uring mdr_uring_t;
+
+/*
+ * Create a new io_uring with room for `entries` queued operations,
+ * and completions of as many transports.
+ *
+ * More transports than `entries` may be used, completions which don't fit
+ * are held by the kernel and picked up by `mdr_uring_submit`.
+ *
+ * Returns NULL and sets errno on error,
+ * ENOSYS if io_uring is not supported.
+ */
+mdr_uring_t* mdr_uring_new(unsigned int entries);
+
+/*
+ * Free the ring and any transports which have been closed
+ * but still had operations in flight.
+ *
+ * All transports created from the ring must have been closed.
+ */
+void mdr_uring_free(mdr_uring_t*);
+
+/*
+ * Get the file descriptor of the ring,
+ * it is readable whenever there are completions to handle.
+ */
+int mdr_uring_get_fd(mdr_uring_t*);
+
+/*
+ * Submit all queued operations to the kernel with a single system call
+ * and handle any completions.
+ *
+ * Returns 0 on success, returns -1 and sets errno on error.
+ */
+int mdr_uring_submit(mdr_uring_t*);
+
+/*
+ * Create a non-blocking transport reading from and writing to the
+ * connected socket `sock` through the ring.
+ *
+ * Closing the transport closes the socket,
+ * freeing it without closing is not supported.
+ *
+ * Returns NULL and sets errno on error.
+ */
+mdr_transport_t* mdr_uring_new_transport(mdr_uring_t*, int sock);
+
+#endif /* __MDR_URING_H__ */
@@ -37,6 +37,28 @@ struct subscription
     subscription_t* next;
 };
 
+/*
+ * GET requests which are made often, and are encoded once
+ * into a template the first time they're made.
+ */
+typedef enum
+{
+    TEMPLATE_GET_PROTOCOL_INFO,
+    TEMPLATE_GET_SUPPORT_FUNCTION,
+    TEMPLATE_GET_BATTERY_LEVEL,
+    TEMPLATE_GET_LEFT_RIGHT_BATTERY_LEVEL,
+    TEMPLATE_GET_CRADLE_BATTERY_LEVEL,
+    TEMPLATE_GET_NC_PARAM,
+    TEMPLATE_GET_NC_ASM_PARAM,
+    TEMPLATE_GET_ASM_PARAM,
+    TEMPLATE_GET_EQ_PARAM,
+    TEMPLATE_GET_EQ_NONCUSTOMIZABLE_PARAM,
+    TEMPLATE_GET_VOLUME,
+
+    NUM_TEMPLATES
+}
+template_id_t;
+
 struct mdr_device
 {
     mdr_packetconn_t* conn;
@@ -44,6 +66,8 @@ struct mdr_device
     subscription_t* subscriptions, *subscriptions_tail;
 
     mdr_device_supported_functions_t supported_functions;
+
+    mdr_packetconn_template_t* templates[NUM_TEMPLATES];
 };
 
 mdr_device_t* mdr_device_new_from_packetconn(mdr_packetconn_t* conn)
@@ -59,6 +83,11 @@ mdr_device_t* mdr_device_new_from_packetconn(mdr_packetconn_t* conn)
     memset(&device->supported_functions, 0,
             sizeof(mdr_device_supported_functions_t));
 
+    for (int i = 0; i < NUM_TEMPLATES; i++)
+    {
+        device->templates[i] = NULL;
+    }
+
     return device;
 }
 
@@ -81,6 +110,20 @@ mdr_device_t* mdr_device_new_from_sock(int sock)
     return device;
 }
 
+/*
+ * Free the templates, once no requests made from them are pending.
+ */
+static void mdr_device_free_templates(mdr_device_t* device)
+{
+    for (int i = 0; i < NUM_TEMPLATES; i++)
+    {
+        if (device->templates[i] != NULL)
+        {
+            mdr_packetconn_template_free(device->templates[i]);
+        }
+    }
+}
+
 void mdr_device_free(mdr_device_t* device)
 {
     subscription_t* next;
@@ -96,6 +139,7 @@ void mdr_device_free(mdr_device_t* device)
     }
 
     mdr_packetconn_free(device->conn);
+    mdr_device_free_templates(device);
     free(device);
 }
 
@@ -114,6 +158,7 @@ void mdr_device_close(mdr_device_t* device)
     }
 
     mdr_packetconn_close(device->conn);
+    mdr_device_free_templates(device);
     free(device);
 }
 
@@ -136,6 +181,12 @@ int mdr_device_process_by_availability(mdr_device_t* device,
                                                   writable);
 }
 
+int mdr_device_set_request_priority(mdr_device_t* device,
+                                    mdr_packetconn_priority_t priority)
+{
+    return mdr_packetconn_set_request_priority(device->conn, priority);
+}
+
 mdr_device_supported_functions_t
         mdr_device_get_supported_functions(mdr_device_t* device)
 {
@@ -205,6 +256,66 @@ static void mdr_device_make_request(
             callback_data);
 }
 
+/*
+ * Make a request from the template `template_id`, creating the template
+ * from `request_packet` the first time.
+ *
+ * Falls back to making the request from `request_packet`
+ * if the template can't be created.
+ */
+static void mdr_device_make_template_request(
+        mdr_device_t* device,
+        template_id_t template_id,
+        mdr_packet_t* request_packet,
+        mdr_packetconn_reply_specifier_t reply_specifier,
+        void (*device_result_callback)(mdr_packet_t*, void*),
+        void (*user_result_callback)(),
+        void (*user_error_callback)(void*),
+        void* user_data)
+{
+    if (device->templates[template_id] == NULL)
+    {
+        device->templates[template_id]
+                = mdr_packetconn_template_new(request_packet);
+    }
+
+    if (device->templates[template_id] == NULL)
+    {
+        mdr_device_make_request(device,
+                                request_packet,
+                                reply_specifier,
+                                device_result_callback,
+                                user_result_callback,
+                                user_error_callback,
+                                user_data);
+        return;
+    }
+
+    callback_data_t* callback_data = malloc(sizeof(callback_data_t));
+    if (callback_data == NULL)
+    {
+        if (user_error_callback != NULL) user_error_callback(user_data);
+        return;
+    }
+
+    callback_data->device = device;
+    callback_data->user_result_callback = user_result_callback;
+    callback_data->user_error_callback = user_error_callback;
+    callback_data->user_data = user_data;
+
+    if (mdr_packetconn_make_request_from_template(
+            device->conn,
+            device->templates[template_id],
+            reply_specifier,
+            device_result_callback,
+            error_callback_passthrough,
+            callback_data) == NULL)
+    {
+        free(callback_data);
+        if (user_error_callback != NULL) user_error_callback(user_data);
+    }
+}
+
 static void* mdr_device_add_subscription(
         mdr_device_t* device,
         mdr_packetconn_reply_specifier_t reply_specifier,
@@ -340,8 +451,9 @@ static void mdr_device_init_result_protocol_info(mdr_packet_t* packet,
     request_packet.type = MDR_PACKET_CONNECT_GET_SUPPORT_FUNCTION;
     request_packet.data.connect_get_support_function.fixed_value = 0;
 
-    mdr_device_make_request(
+    mdr_device_make_template_request(
             device,
+            TEMPLATE_GET_SUPPORT_FUNCTION,
             &request_packet,
             (mdr_packetconn_reply_specifier_t){
                 .packet_type = MDR_PACKET_CONNECT_RET_SUPPORT_FUNCTION,
@@ -364,8 +476,9 @@ void mdr_device_init(mdr_device_t* device,
     request_packet.type = MDR_PACKET_CONNECT_GET_PROTOCOL_INFO;
     request_packet.data.connect_get_protocol_info.fixed_value = 0;
 
-    mdr_device_make_request(
+    mdr_device_make_template_request(
             device,
+            TEMPLATE_GET_PROTOCOL_INFO,
             &request_packet,
             (mdr_packetconn_reply_specifier_t){
                 .packet_type = MDR_PACKET_CONNECT_RET_PROTOCOL_INFO,
@@ -625,8 +738,9 @@ int mdr_device_get_battery_level(
         }
     };
 
-    mdr_device_make_request(
+    mdr_device_make_template_request(
             device,
+            TEMPLATE_GET_BATTERY_LEVEL,
             &packet,
             (mdr_packetconn_reply_specifier_t){
                 .packet_type = MDR_PACKET_COMMON_RET_BATTERY_LEVEL,
@@ -723,8 +837,9 @@ int mdr_device_get_left_right_battery_level(
         }
     };
 
-    mdr_device_make_request(
+    mdr_device_make_template_request(
             device,
+            TEMPLATE_GET_LEFT_RIGHT_BATTERY_LEVEL,
             &packet,
             (mdr_packetconn_reply_specifier_t){
                 .packet_type = MDR_PACKET_COMMON_RET_BATTERY_LEVEL,
@@ -820,8 +935,9 @@ int mdr_device_get_cradle_battery_level(
         }
     };
 
-    mdr_device_make_request(
+    mdr_device_make_template_request(
             device,
+            TEMPLATE_GET_CRADLE_BATTERY_LEVEL,
             &packet,
             (mdr_packetconn_reply_specifier_t){
                 .packet_type = MDR_PACKET_COMMON_RET_BATTERY_LEVEL,
@@ -1019,20 +1135,24 @@ int mdr_device_get_noise_cancelling_enabled(
 
     mdr_packet_t request_packet;
     request_packet.type = MDR_PACKET_NCASM_GET_PARAM;
+    template_id_t template_id;
 
     if (device->supported_functions.ambient_sound_mode)
     {
         request_packet.data.ncasm_get_param.inquired_type
             = MDR_PACKET_NCASM_INQUIRED_TYPE_NOISE_CANCELLING_AND_ASM;
+        template_id = TEMPLATE_GET_NC_ASM_PARAM;
     }
     else
     {
         request_packet.data.ncasm_get_param.inquired_type
             = MDR_PACKET_NCASM_INQUIRED_TYPE_NOISE_CANCELLING;
+        template_id = TEMPLATE_GET_NC_PARAM;
     }
 
-    mdr_device_make_request(
+    mdr_device_make_template_request(
             device,
+            template_id,
             &request_packet,
             (mdr_packetconn_reply_specifier_t){
                 .packet_type = MDR_PACKET_NCASM_RET_PARAM,
@@ -1160,20 +1280,24 @@ int mdr_device_get_ambient_sound_mode_settings(
 
     mdr_packet_t request_packet;
     request_packet.type = MDR_PACKET_NCASM_GET_PARAM;
+    template_id_t template_id;
 
     if (device->supported_functions.noise_cancelling)
     {
         request_packet.data.ncasm_get_param.inquired_type
             = MDR_PACKET_NCASM_INQUIRED_TYPE_NOISE_CANCELLING_AND_ASM;
+        template_id = TEMPLATE_GET_NC_ASM_PARAM;
     }
     else
     {
         request_packet.data.ncasm_get_param.inquired_type
             = MDR_PACKET_NCASM_INQUIRED_TYPE_ASM;
+        template_id = TEMPLATE_GET_ASM_PARAM;
     }
 
-    mdr_device_make_request(
+    mdr_device_make_template_request(
             device,
+            template_id,
             &request_packet,
             (mdr_packetconn_reply_specifier_t){
                 .packet_type = MDR_PACKET_NCASM_RET_PARAM,
@@ -1565,14 +1689,18 @@ int mdr_device_get_eq_preset_and_levels(
         },
     };
 
+    template_id_t template_id = TEMPLATE_GET_EQ_PARAM;
+
     if (device->supported_functions.eq_non_customizable)
     {
         request_packet.data.eqebb_get_param.inquired_type
             = MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE;
+        template_id = TEMPLATE_GET_EQ_NONCUSTOMIZABLE_PARAM;
     }
 
-    mdr_device_make_request(
+    mdr_device_make_template_request(
             device,
+            template_id,
             &request_packet,
             (mdr_packetconn_reply_specifier_t){
                 .packet_type = MDR_PACKET_EQEBB_RET_PARAM,
@@ -2197,8 +2325,9 @@ int mdr_device_playback_get_volume(
         },
     };
 
-    mdr_device_make_request(
+    mdr_device_make_template_request(
             device,
+            TEMPLATE_GET_VOLUME,
             &request_packet,
             (mdr_packetconn_reply_specifier_t){
                 .packet_type = MDR_PACKET_PLAY_RET_PARAM,
@@ -22,9 +22,38 @@
 
 #include "mdr/frame.h"
 
+#include <malloc.h>
 #include <stdlib.h>
 #include <string.h>
 
+/*
+ * Frames are pooled in power-of-two size classes starting at
+ * FRAME_POOL_MIN_SIZE bytes, larger frames are never pooled.
+ */
+#define FRAME_POOL_MIN_SIZE 64
+#define FRAME_POOL_NUM_CLASSES 8
+
+/*
+ * Maximum number of idle frames kept per size class.
+ */
+#define FRAME_POOL_CLASS_DEPTH 4
+
+typedef struct pool_entry pool_entry_t;
+
+/*
+ * An idle frame, the storage of the frame is reused as a list node.
+ */
+struct pool_entry
+{
+    pool_entry_t* next;
+};
+
+struct mdr_frame_pool
+{
+    pool_entry_t* idle[FRAME_POOL_NUM_CLASSES];
+    int num_idle[FRAME_POOL_NUM_CLASSES];
+};
+
 mdr_frame_t* mdr_frame_dup(mdr_frame_t* frame)
 {
     mdr_frame_t* new_frame =
@@ -59,3 +88,130 @@ uint8_t mdr_frame_compute_checksum(mdr_frame_t* frame)
 
     return checksum;
 }
+
+/*
+ * Get the smallest size class holding frames of `size` bytes.
+ *
+ * Returns the index of the class or -1 if the frame is too large to pool.
+ */
+static int frame_pool_class(size_t size)
+{
+    size_t class_size = FRAME_POOL_MIN_SIZE;
+
+    for (int i = 0; i < FRAME_POOL_NUM_CLASSES; i++)
+    {
+        if (size <= class_size) return i;
+        class_size <<= 1;
+    }
+
+    return -1;
+}
+
+mdr_frame_pool_t* mdr_frame_pool_new()
+{
+    mdr_frame_pool_t* pool = malloc(sizeof(mdr_frame_pool_t));
+    if (pool == NULL) return NULL;
+
+    for (int i = 0; i < FRAME_POOL_NUM_CLASSES; i++)
+    {
+        pool->idle[i] = NULL;
+        pool->num_idle[i] = 0;
+    }
+
+    return pool;
+}
+
+void mdr_frame_pool_free(mdr_frame_pool_t* pool)
+{
+    if (pool == NULL) return;
+
+    for (int i = 0; i < FRAME_POOL_NUM_CLASSES; i++)
+    {
+        pool_entry_t* next = NULL;
+        for (pool_entry_t* entry = pool->idle[i]; entry != NULL; entry = next)
+        {
+            next = entry->next;
+            free(entry);
+        }
+    }
+
+    free(pool);
+}
+
+mdr_frame_t* mdr_frame_pool_acquire(mdr_frame_pool_t* pool,
+                                    uint32_t payload_length)
+{
+    size_t size = MDR_FRAME_EMPTY_LEN + (size_t) payload_length;
+    int class = frame_pool_class(size);
+
+    mdr_frame_t* frame;
+    if (class < 0)
+    {
+        frame = malloc(size);
+    }
+    else if (pool != NULL && pool->idle[class] != NULL)
+    {
+        pool_entry_t* entry = pool->idle[class];
+        pool->idle[class] = entry->next;
+        pool->num_idle[class]--;
+
+        frame = (mdr_frame_t*) entry;
+    }
+    else
+    {
+        // Always allocate the whole class so the frame can be reused
+        // for any payload in it once released.
+        frame = malloc((size_t) FRAME_POOL_MIN_SIZE << class);
+    }
+
+    if (frame == NULL) return NULL;
+
+    frame->payload_length = payload_length;
+
+    return frame;
+}
+
+/*
+ * Get the largest size class whose frames fit in an allocation
+ * of `size` bytes.
+ *
+ * Returns the index of the class or -1 if the allocation is too small
+ * or too large to pool.
+ */
+static int frame_pool_class_within(size_t size)
+{
+    if (size < FRAME_POOL_MIN_SIZE) return -1;
+
+    size_t class_size = FRAME_POOL_MIN_SIZE;
+    for (int i = 0; i < FRAME_POOL_NUM_CLASSES; i++)
+    {
+        if (size < class_size << 1) return i;
+        class_size <<= 1;
+    }
+
+    return -1;
+}
+
+void mdr_frame_pool_release(mdr_frame_pool_t* pool, mdr_frame_t* frame)
+{
+    if (frame == NULL) return;
+
+    // Pool by the size of the allocation rather than the payload length,
+    // so frames which weren't acquired from a pool, e.g. duplicated ones,
+    // are never handed out for payloads they can't hold.
+    int class = frame_pool_class_within(malloc_usable_size(frame));
+
+    if (pool == NULL
+            || class < 0
+            || pool->num_idle[class] >= FRAME_POOL_CLASS_DEPTH)
+    {
+        free(frame);
+        return;
+    }
+
+    void* storage = frame;
+    pool_entry_t* entry = storage;
+    entry->next = pool->idle[class];
+    pool->idle[class] = entry;
+    pool->num_idle[class]++;
+}
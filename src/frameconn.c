@@ -24,34 +24,121 @@
 
 #include "mdr/errors.h"
 
+#include "frameconn/escape.h"
+#include "frameconn/buffer.h"
+
 #include <bluetooth/rfcomm.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <arpa/inet.h>
+#include <sys/uio.h>
+
+/*
+ * The default limit on the size of each I/O buffer,
+ * can be changed per connection with `mdr_frameconn_set_buffer_limit`.
+ */
+#ifndef FRAME_BUF_DEFAULT_LIMIT
+#define FRAME_BUF_DEFAULT_LIMIT 8192
+#endif
 
-#ifndef FRAME_BUF_SIZE
-#define FRAME_BUF_SIZE 8192
+#if FRAME_BUF_DEFAULT_LIMIT & (FRAME_BUF_DEFAULT_LIMIT - 1)
+#error "FRAME_BUF_DEFAULT_LIMIT must be a power of two"
 #endif
 
-struct mdr_frameconn
+/*
+ * Number of bytes preceding the payload in a frame,
+ * the data type, sequence id and payload length.
+ */
+#define FRAME_HEADER_LEN (MDR_FRAME_EMPTY_LEN - 1)
+
+/*
+ * The largest payload accepted from the remote end,
+ * longer frames are dropped.
+ */
+#define FRAME_MAX_PAYLOAD_LEN(connection) \
+    ((connection)->buf_limit - MDR_FRAME_EMPTY_LEN)
+
+/*
+ * Decoder state for the frame currently being read.
+ */
+typedef enum
 {
-    int sock;
-    uint8_t read_buf[FRAME_BUF_SIZE];
-    size_t read_buf_len;
-    bool read_started;
+    // Waiting for a start byte, anything else is dropped.
+    READ_STATE_IDLE,
+    // Reading the data type, sequence id and payload length.
+    READ_STATE_HEADER,
+    // Reading the payload straight into `read_frame`.
+    READ_STATE_PAYLOAD,
+    // Reading the checksum byte.
+    READ_STATE_CHECKSUM,
+    // The frame is complete, waiting for the end byte.
+    READ_STATE_END,
+}
+read_state_t;
 
-    uint8_t write_buf[FRAME_BUF_SIZE];
-    size_t write_buf_len;
+struct mdr_frameconn
+{
+    mdr_transport_t* transport;
+
+    // Received frames are acquired from this pool.
+    mdr_frame_pool_t* frame_pool;
+
+    /*
+     * Both I/O buffers are taken from the shared buffer slab when first
+     * needed and may be given back by `mdr_frameconn_release_buffers`.
+     * Their sizes are powers of two no larger than `buf_limit`.
+     */
+    size_t buf_limit;
+
+    /*
+     * Bytes in [read_head, read_tail) of the read buffer have been read
+     * from the socket but not yet passed through the decoder.
+     *
+     * The decoder drains the buffer before the socket is read again,
+     * so every read starts at the beginning of the buffer.
+     */
+    uint8_t* read_buf;
+    size_t read_buf_size;
+    // The last read filled the buffer, use a larger one for the next.
+    bool read_buf_grow;
+    size_t read_head;
+    size_t read_tail;
+
+    read_state_t read_state;
+    // The previous byte was an escape byte.
+    bool read_escaped;
+    // Number of bytes decoded in the current state.
+    size_t read_pos;
+    uint8_t read_header[FRAME_HEADER_LEN];
+    // Sum of the bytes decoded so far in the current frame.
+    uint8_t read_checksum;
+    // The frame being decoded, acquired once its length is known.
+    mdr_frame_t* read_frame;
+    // Number of frames dropped because they were corrupt.
+    size_t bad_frames;
+
+    /*
+     * The write buffer holds escaped frames which have been queued but
+     * not yet written to the socket.
+     *
+     * Frames are always stored contiguously. Queued bytes are
+     * [write_head, write_tail) unless `write_wrap` is non-zero, in which
+     * case the buffer has wrapped and the queued bytes are
+     * [write_head, write_wrap) followed by [0, write_tail).
+     */
+    uint8_t* write_buf;
+    size_t write_buf_size;
+    size_t write_head;
+    size_t write_tail;
+    size_t write_wrap;
 };
 
 mdr_frameconn_t* mdr_frameconn_connect(bdaddr_t addr, uint8_t channel)
 {
-    mdr_frameconn_t* connection = malloc(sizeof(mdr_frameconn_t));
-    if (connection == NULL) return NULL;
-
     struct sockaddr_rc sock_addr;
     sock_addr.rc_family = AF_BLUETOOTH;
     sock_addr.rc_channel = channel;
@@ -64,189 +151,532 @@ mdr_frameconn_t* mdr_frameconn_connect(bdaddr_t addr, uint8_t channel)
                 (const struct sockaddr*) &sock_addr,
                 sizeof(struct sockaddr_rc)) < 0)
     {
+        close(sock);
         return NULL;
     }
 
-    connection->sock = sock;
-    connection->read_buf_len = 0;
-    connection->read_started = false;
-    connection->write_buf_len = 0;
+    mdr_frameconn_t* connection = mdr_frameconn_new(sock);
+    if (connection == NULL)
+    {
+        close(sock);
+        return NULL;
+    }
 
     return connection;
 }
 
 mdr_frameconn_t* mdr_frameconn_new(int sock)
+{
+    mdr_transport_t* transport = mdr_transport_new_fd(sock);
+    if (transport == NULL) return NULL;
+
+    mdr_frameconn_t* connection = mdr_frameconn_new_from_transport(transport);
+    if (connection == NULL)
+    {
+        mdr_transport_free(transport);
+        return NULL;
+    }
+
+    return connection;
+}
+
+mdr_frameconn_t* mdr_frameconn_new_from_transport(mdr_transport_t* transport)
 {
     mdr_frameconn_t *connection = malloc(sizeof(mdr_frameconn_t));
     if (connection == NULL) return NULL;
 
-    connection->sock = sock;
+    connection->frame_pool = mdr_frame_pool_new();
+    if (connection->frame_pool == NULL)
+    {
+        free(connection);
+        return NULL;
+    }
 
-    connection->read_buf_len = 0;
-    connection->read_started = false;
-    connection->write_buf_len = 0;
+    connection->transport = transport;
+
+    connection->buf_limit = FRAME_BUF_DEFAULT_LIMIT;
+
+    connection->read_buf = NULL;
+    connection->read_buf_size = 0;
+    connection->read_buf_grow = false;
+    connection->read_head = 0;
+    connection->read_tail = 0;
+    connection->read_state = READ_STATE_IDLE;
+    connection->read_escaped = false;
+    connection->read_pos = 0;
+    connection->read_checksum = 0;
+    connection->read_frame = NULL;
+    connection->bad_frames = 0;
+    connection->write_buf = NULL;
+    connection->write_buf_size = 0;
+    connection->write_head = 0;
+    connection->write_tail = 0;
+    connection->write_wrap = 0;
 
     return connection;
 }
 
 int mdr_frameconn_get_socket(mdr_frameconn_t* connection)
 {
-    return connection->sock;
+    return mdr_transport_poll_fd(connection->transport);
+}
+
+mdr_frame_pool_t* mdr_frameconn_frame_pool(mdr_frameconn_t* connection)
+{
+    return connection->frame_pool;
+}
+
+int mdr_frameconn_set_buffer_limit(mdr_frameconn_t* connection,
+                                   size_t limit)
+{
+    if (limit < BUFFER_MIN_SIZE
+            || limit > BUFFER_MAX_SIZE
+            || (limit & (limit - 1)) != 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    connection->buf_limit = limit;
+    return 0;
+}
+
+bool mdr_frameconn_has_buffers(mdr_frameconn_t* connection)
+{
+    return connection->read_buf != NULL || connection->write_buf != NULL;
+}
+
+void mdr_frameconn_release_buffers(mdr_frameconn_t* connection)
+{
+    if (connection->read_head == connection->read_tail)
+    {
+        buffer_put(connection->read_buf, connection->read_buf_size);
+        connection->read_buf = NULL;
+        connection->read_buf_size = 0;
+        connection->read_buf_grow = false;
+        connection->read_head = 0;
+        connection->read_tail = 0;
+    }
+
+    if (!mdr_frameconn_waiting_write(connection))
+    {
+        buffer_put(connection->write_buf, connection->write_buf_size);
+        connection->write_buf = NULL;
+        connection->write_buf_size = 0;
+        connection->write_head = 0;
+        connection->write_tail = 0;
+    }
+}
+
+size_t mdr_frameconn_bad_frames(mdr_frameconn_t* connection)
+{
+    return connection->bad_frames;
 }
 
 bool mdr_frameconn_waiting_write(mdr_frameconn_t* connection)
 {
-    return connection->write_buf_len > 0;
+    return connection->write_head != connection->write_tail
+        || connection->write_wrap != 0;
 }
 
-void mdr_frameconn_close(mdr_frameconn_t* connection)
+bool mdr_frameconn_waiting_read(mdr_frameconn_t* connection)
 {
-    close(connection->sock);
+    return connection->read_head != connection->read_tail
+        || mdr_transport_has_buffered_input(connection->transport);
+}
+
+static void mdr_frameconn_free_self(mdr_frameconn_t* connection)
+{
+    mdr_frame_pool_release(connection->frame_pool, connection->read_frame);
+    mdr_frame_pool_free(connection->frame_pool);
+    buffer_put(connection->read_buf, connection->read_buf_size);
+    buffer_put(connection->write_buf, connection->write_buf_size);
     free(connection);
 }
 
+void mdr_frameconn_close(mdr_frameconn_t* connection)
+{
+    mdr_transport_close(connection->transport);
+    mdr_frameconn_free_self(connection);
+}
+
 void mdr_frameconn_free(mdr_frameconn_t* connection)
 {
-    free(connection);
+    mdr_transport_free(connection->transport);
+    mdr_frameconn_free_self(connection);
 }
 
 int mdr_frameconn_flush_write(mdr_frameconn_t* connection)
 {
-    size_t i = 0;
-    while (i < connection->write_buf_len)
+    while (mdr_frameconn_waiting_write(connection))
     {
-        int bytes_written;
+        struct iovec iov[2];
+        int iovcnt = 1;
+
+        iov[0].iov_base = &connection->write_buf[connection->write_head];
+        if (connection->write_wrap != 0)
+        {
+            iov[0].iov_len = connection->write_wrap - connection->write_head;
+            iov[1].iov_base = connection->write_buf;
+            iov[1].iov_len = connection->write_tail;
+            iovcnt = 2;
+        }
+        else
+        {
+            iov[0].iov_len = connection->write_tail - connection->write_head;
+        }
+
+        ssize_t bytes_written;
 write_bytes:
-        bytes_written = write(connection->sock,
-                              &connection->write_buf[i],
-                              connection->write_buf_len - i);
+        bytes_written = mdr_transport_writev(connection->transport,
+                                             iov,
+                                             iovcnt);
         if (bytes_written < 0)
         {
             if (errno == EINTR)
             {
                 goto write_bytes;
             }
-            if (i > 0)
-            {
-                memmove(connection->write_buf,
-                        &connection->write_buf[i],
-                        connection->read_buf_len - i);
-                connection->write_buf_len -= i;
-            }
             return -1;
         }
+
+#ifdef __DEBUG
+        fprintf(stderr, "wrote %zd bytes\n", bytes_written);
+        for (ssize_t j = 0; j < bytes_written; j++)
+        {
+            fprintf(stderr, "%02x ", j < iov[0].iov_len
+                    ? ((uint8_t*) iov[0].iov_base)[j]
+                    : ((uint8_t*) iov[1].iov_base)[j - iov[0].iov_len]);
+        }
+        fprintf(stderr, "\n");
+#endif
+
+        if (connection->write_wrap != 0
+                && (size_t) bytes_written >= iov[0].iov_len)
+        {
+            connection->write_head = bytes_written - iov[0].iov_len;
+            connection->write_wrap = 0;
+        }
+        else
+        {
+            connection->write_head += bytes_written;
+        }
     }
 
-    connection->write_buf_len = 0;
+    connection->write_head = 0;
+    connection->write_tail = 0;
     return 0;
 }
 
-#define FRAME_START_BYTE  ((uint8_t) 0x3e)
-#define FRAME_ESCAPE_BYTE ((uint8_t) 0x3d)
-#define FRAME_END_BYTE    ((uint8_t) 0x3c)
-#define FRAME_ESCAPE_MASK ((uint8_t) 0x10)
+/*
+ * Drop the frame currently being decoded, if any,
+ * and wait for the next start byte.
+ */
+static void mdr_frameconn_reset_read(mdr_frameconn_t* connection)
+{
+    mdr_frame_pool_release(connection->frame_pool, connection->read_frame);
+    connection->read_frame = NULL;
+    connection->read_state = READ_STATE_IDLE;
+    connection->read_escaped = false;
+    connection->read_pos = 0;
+    connection->read_checksum = 0;
+}
 
 /*
- * Attempt to to unescape and read a frame.
- *
- * The parameter`escaped` is the bytes between the start and end bytes.
+ * Drop a frame which has been started but is corrupt.
+ */
+static void mdr_frameconn_drop_read(mdr_frameconn_t* connection)
+{
+    connection->bad_frames++;
+    mdr_frameconn_reset_read(connection);
+}
+
+/*
+ * Called once all header bytes have been decoded,
+ * acquires the frame the payload is decoded into.
  *
- * Returns a pointer to an allocated frame or returns NULL and sets
- * errno to MDR_E_INVALID_FRAME if the frame is invalid.
+ * Returns 0 on success or if the header is invalid (in which case the
+ * frame is dropped), returns -1 and sets errno on allocation failure.
  */
-static mdr_frame_t* mdr_frameconn_unescape_frame(uint8_t* escaped,
-                                                 size_t escaped_len)
+static int mdr_frameconn_header_done(mdr_frameconn_t* connection)
 {
-    uint8_t* frame_bytes = malloc(escaped_len);
+    uint32_t payload_length;
+    memcpy(&payload_length, &connection->read_header[2], sizeof(uint32_t));
+    payload_length = ntohl(payload_length);
 
-    size_t read, write = 0;
-    for (read = 0; read < escaped_len; read++, write++)
+    if (payload_length > FRAME_MAX_PAYLOAD_LEN(connection))
     {
-        uint8_t b = escaped[read];
+        mdr_frameconn_drop_read(connection);
+        return 0;
+    }
 
-        if (b == FRAME_ESCAPE_BYTE && read + 1 <escaped_len)
-        {
-            read++;
-            frame_bytes[write] = escaped[read] | FRAME_ESCAPE_MASK;
-        }
-        else
-        {
-            frame_bytes[write] = b;
-        }
+    mdr_frame_t* frame = mdr_frame_pool_acquire(connection->frame_pool,
+                                                payload_length);
+    if (frame == NULL)
+    {
+        mdr_frameconn_reset_read(connection);
+        return -1;
     }
 
-    if (write < MDR_FRAME_EMPTY_LEN)
+    frame->data_type = connection->read_header[0];
+    frame->sequence_id = connection->read_header[1];
+
+    connection->read_frame = frame;
+    connection->read_pos = 0;
+    connection->read_state = payload_length > 0
+            ? READ_STATE_PAYLOAD
+            : READ_STATE_CHECKSUM;
+
+    return 0;
+}
+
+/*
+ * Copy the run of bytes at the head of the read buffer that need no
+ * unescaping straight into the payload of the frame being decoded,
+ * adding them to the checksum in the same pass.
+ *
+ * Must only be called in READ_STATE_PAYLOAD when the previous byte
+ * was not an escape byte.
+ */
+static void mdr_frameconn_copy_payload_run(mdr_frameconn_t* connection)
+{
+    mdr_frame_t* frame = connection->read_frame;
+
+    size_t available = connection->read_tail - connection->read_head;
+    if (available > frame->payload_length - connection->read_pos)
     {
-        errno = MDR_E_INVALID_FRAME;
-        return NULL;
+        available = frame->payload_length - connection->read_pos;
     }
 
-    mdr_frame_t* frame = (mdr_frame_t*) frame_bytes;
-    frame->payload_length = ntohl(frame->payload_length);
-    size_t frame_len = MDR_FRAME_EMPTY_LEN + frame->payload_length;
+    const uint8_t* in = &connection->read_buf[connection->read_head];
+    uint8_t* out = &mdr_frame_payload(frame)[connection->read_pos];
+    size_t run = escape_find_special(in, available);
 
-    if (write < frame_len)
+    uint8_t checksum = connection->read_checksum;
+    for (size_t i = 0; i < run; i++)
     {
-        errno = MDR_E_INVALID_FRAME;
-        return NULL;
+        out[i] = in[i];
+        checksum += in[i];
     }
+    connection->read_checksum = checksum;
 
-    // Shrink allocation if possible
-    frame_bytes = realloc(frame_bytes,
-                          MDR_FRAME_EMPTY_LEN + frame->payload_length);
+    connection->read_pos += run;
+    connection->read_head += run;
 
-    return (mdr_frame_t*) frame_bytes;
+    if (connection->read_pos == frame->payload_length)
+    {
+        connection->read_state = READ_STATE_CHECKSUM;
+    }
 }
 
 /*
- * Reads a frame from the read buffer.
+ * Decodes buffered bytes until a frame is complete.
+ *
+ * Bytes are unescaped straight into the destination frame as they are
+ * consumed from the read buffer, every buffered byte is only looked at once.
+ * Runs of payload bytes between escapes are located with
+ * `escape_find_special` and copied in bulk.
+ * The checksum is accumulated while decoding and frames with a bad
+ * checksum are dropped.
  *
- * Returns a frame if a valid frame is found in the read buffer,
- * otherwise returns NULL.
- * If the buffer contained an invalid frame errno is set
- * to MDR_E_INVALID_FRAME, otherwise it is set to 0.
+ * Returns a frame if a complete frame was decoded, otherwise returns NULL.
+ * errno is set to 0 if the read buffer has been exhausted or to an
+ * error code if an error occured.
  */
 static mdr_frame_t* mdr_frameconn_next_frame(mdr_frameconn_t* connection)
 {
-    for (size_t i = 0; i < connection->read_buf_len; i++)
+    while (connection->read_head != connection->read_tail)
     {
-        if (connection->read_buf[i] == FRAME_START_BYTE)
+        if (connection->read_state == READ_STATE_PAYLOAD
+                && !connection->read_escaped)
         {
-            memmove(connection->read_buf,
-                    &connection->read_buf[i+1],
-                    connection->read_buf_len - i+1);
-            connection->read_buf_len -= i+1;
-            connection->read_started = true;
-            i = -1;
+            mdr_frameconn_copy_payload_run(connection);
+
+            if (connection->read_head == connection->read_tail)
+            {
+                break;
+            }
         }
-        else if (connection->read_buf[i] == FRAME_END_BYTE
-              && connection->read_started)
+
+        uint8_t b = connection->read_buf[connection->read_head];
+        connection->read_head++;
+
+        if (b == FRAME_START_BYTE)
         {
-            mdr_frame_t* frame =
-                mdr_frameconn_unescape_frame(connection->read_buf, i);
+            // A start byte always begins a new frame,
+            // even if the previous one is incomplete.
+            if (connection->read_state != READ_STATE_IDLE)
+            {
+                mdr_frameconn_drop_read(connection);
+            }
+            connection->read_state = READ_STATE_HEADER;
+            continue;
+        }
 
-            memmove(connection->read_buf,
-                    &connection->read_buf[i+1],
-                    connection->read_buf_len - i+1);
-            connection->read_buf_len -= i+1;
-            connection->read_started = false;
+        if (connection->read_state == READ_STATE_IDLE)
+        {
+            continue;
+        }
+
+        if (b == FRAME_END_BYTE)
+        {
+            if (connection->read_state == READ_STATE_END)
+            {
+                mdr_frame_t* frame = connection->read_frame;
+                connection->read_frame = NULL;
+                mdr_frameconn_reset_read(connection);
 
-            if (frame != NULL) return frame;
+                return frame;
+            }
+
+            // The frame ended early, drop it.
+            mdr_frameconn_drop_read(connection);
+            continue;
         }
-    }
 
-    if (connection->read_buf_len >= FRAME_BUF_SIZE)
-    {
-        // Buffer is full and no start or end can be read from it.
-        // Clear the buffer and start over.
-        connection->read_buf_len = 0;
-        connection->read_started = false;
+        if (connection->read_escaped)
+        {
+            b |= FRAME_ESCAPE_MASK;
+            connection->read_escaped = false;
+        }
+        else if (b == FRAME_ESCAPE_BYTE)
+        {
+            connection->read_escaped = true;
+            continue;
+        }
+
+        switch (connection->read_state)
+        {
+            case READ_STATE_IDLE:
+                break;
+
+            case READ_STATE_HEADER:
+                connection->read_header[connection->read_pos] = b;
+                connection->read_pos++;
+                connection->read_checksum += b;
+
+                if (connection->read_pos == FRAME_HEADER_LEN)
+                {
+                    if (mdr_frameconn_header_done(connection) < 0)
+                    {
+                        return NULL;
+                    }
+                }
+                break;
+
+            case READ_STATE_PAYLOAD:
+                mdr_frame_payload(connection->read_frame)
+                        [connection->read_pos] = b;
+                connection->read_pos++;
+                connection->read_checksum += b;
+
+                if (connection->read_pos
+                        == connection->read_frame->payload_length)
+                {
+                    connection->read_state = READ_STATE_CHECKSUM;
+                }
+                break;
+
+            case READ_STATE_CHECKSUM:
+                if (b != connection->read_checksum)
+                {
+                    // Checked here so corrupt frames never reach the
+                    // caller, the frame goes back to the pool.
+                    mdr_frameconn_drop_read(connection);
+                    break;
+                }
+
+                *mdr_frame_checksum(connection->read_frame) = b;
+                connection->read_state = READ_STATE_END;
+                break;
+
+            case READ_STATE_END:
+                // Trailing bytes after the checksum are ignored.
+                break;
+        }
     }
 
     errno = 0;
     return NULL;
 }
 
+/*
+ * Read once from the socket into the read buffer.
+ *
+ * Must only be called once the decoder has drained the buffer.
+ *
+ * Returns 0 on success, returns -1 and sets errno on error.
+ */
+static int mdr_frameconn_fill_read(mdr_frameconn_t* connection)
+{
+    // The decoder has drained the buffer at this point,
+    // rewind it so the whole buffer is available to a single read.
+    connection->read_head = 0;
+    connection->read_tail = 0;
+
+    if (connection->read_buf == NULL || connection->read_buf_grow)
+    {
+        size_t size = connection->read_buf == NULL
+                ? BUFFER_MIN_SIZE
+                : connection->read_buf_size << 1;
+
+        uint8_t* read_buf = buffer_get(size);
+        if (read_buf != NULL)
+        {
+            buffer_put(connection->read_buf, connection->read_buf_size);
+            connection->read_buf = read_buf;
+            connection->read_buf_size = size;
+        }
+        else if (connection->read_buf == NULL)
+        {
+            return -1;
+        }
+        // Otherwise keep reading into the smaller buffer.
+
+        connection->read_buf_grow = false;
+    }
+
+    int bytes_read;
+read_bytes:
+    bytes_read = mdr_transport_read(connection->transport,
+                                    connection->read_buf,
+                                    connection->read_buf_size);
+    if (bytes_read < 0)
+    {
+        if (errno == EINTR)
+        {
+            goto read_bytes;
+        }
+        return -1;
+    }
+    if (bytes_read == 0)
+    {
+        errno = MDR_E_CLOSED;
+        return -1;
+    }
+
+#ifdef __DEBUG
+    fprintf(stderr, "read %d bytes\n", bytes_read);
+    for (int i = 0; i < bytes_read; i++)
+    {
+        fprintf(stderr, "%02x ", connection->read_buf[i]);
+    }
+    fprintf(stderr, "\n");
+#endif
+
+    connection->read_tail += bytes_read;
+
+    if ((size_t) bytes_read == connection->read_buf_size
+            && connection->read_buf_size < connection->buf_limit)
+    {
+        // The read filled the buffer so more data is likely waiting,
+        // grow the buffer for the next read.
+        connection->read_buf_grow = true;
+    }
+
+    return 0;
+}
+
 mdr_frame_t* mdr_frameconn_read_frame(mdr_frameconn_t* connection)
 {
     while (1)
@@ -259,170 +689,377 @@ mdr_frame_t* mdr_frameconn_read_frame(mdr_frameconn_t* connection)
             return NULL;
         }
 
-        int bytes_read;
-read_bytes:
-        bytes_read = read(connection->sock,
-                          &connection->read_buf[connection->read_buf_len],
-                          FRAME_BUF_SIZE - connection->read_buf_len);
-        if (bytes_read < 0)
+        if (mdr_frameconn_fill_read(connection) < 0)
         {
-            if (errno == EINTR)
-            {
-                goto read_bytes;
-            }
             return NULL;
         }
+    }
+}
 
-#ifdef __DEBUG
-        fprintf(stderr, "read %d bytes\n", bytes_read);
-        for (int i = 0; i < bytes_read; i++)
+int mdr_frameconn_read_frames(mdr_frameconn_t* connection,
+                              mdr_frame_t** frames,
+                              int max)
+{
+    int count = 0;
+
+    while (count < max)
+    {
+        mdr_frame_t* frame = mdr_frameconn_next_frame(connection);
+        if (frame != NULL)
         {
-            fprintf(stderr, "%02x ",
-                    connection->read_buf[connection->read_buf_len + i]);
+            frames[count] = frame;
+            count++;
+            continue;
         }
-        fprintf(stderr, "\n");
-#endif
 
-        connection->read_buf_len += bytes_read;
+        if (errno != 0)
+        {
+            break;
+        }
+
+        // Only go back to the socket if nothing has been decoded yet,
+        // so a blocking socket is never waited on with frames in hand.
+        if (count > 0)
+        {
+            return count;
+        }
+
+        if (mdr_frameconn_fill_read(connection) < 0)
+        {
+            break;
+        }
+    }
+
+    if (count == 0 && max > 0)
+    {
+        return -1;
     }
+
+    return count;
 }
 
-static uint8_t* mdr_frameconn_escape_frame(mdr_frame_t* frame,
-                                           size_t* escaped_len)
+int mdr_frameconn_read_buffered_frames(mdr_frameconn_t* connection,
+                                       mdr_frame_t** frames,
+                                       int max)
 {
-    size_t frame_len = MDR_FRAME_EMPTY_LEN + frame->payload_length;
+    int count = 0;
 
-    uint32_t payload_length_bytes = htonl(frame->payload_length);
+    while (count < max)
+    {
+        mdr_frame_t* frame = mdr_frameconn_next_frame(connection);
+        if (frame != NULL)
+        {
+            frames[count] = frame;
+            count++;
+            continue;
+        }
 
-    uint8_t* frame_bytes = (uint8_t*) frame;
+        if (errno != 0)
+        {
+            break;
+        }
 
-    size_t allocated = 2 + (frame_len + 2) * 9 / 8;
-    uint8_t* escaped = malloc(allocated);
-    if (escaped == NULL) return NULL;
+        // Input the transport has already received is read like bytes
+        // in the read buffer, it never waits for the socket.
+        if (count > 0
+                || !mdr_transport_has_buffered_input(connection->transport))
+        {
+            errno = EAGAIN;
+            break;
+        }
 
-#define ENSURE_ESCAPED_BUFFER(n) \
-    if (write + (n - 1) >= allocated) \
-    { \
-        allocated = (allocated + 2) * 9 / 8; \
-        escaped = realloc(escaped, allocated); \
-        if (escaped == NULL) return NULL; \
+        if (mdr_frameconn_fill_read(connection) < 0)
+        {
+            break;
+        }
     }
 
-    size_t read, write = 0;
+    if (count == 0 && max > 0)
+    {
+        return -1;
+    }
 
-    escaped[write] = FRAME_START_BYTE;
-    write++;
+    return count;
+}
+
+/*
+ * Replace the write buffer with one large enough for the queued bytes
+ * plus `len` more, moving the queued bytes to the start of it.
+ *
+ * Returns 0 on success, returns -1 and sets errno on error, EWOULDBLOCK if
+ * the buffer would grow past the buffer limit.
+ */
+static int mdr_frameconn_grow_write(mdr_frameconn_t* connection, size_t len)
+{
+    size_t queued;
+    if (connection->write_wrap != 0)
+    {
+        queued = connection->write_wrap - connection->write_head
+               + connection->write_tail;
+    }
+    else
+    {
+        queued = connection->write_tail - connection->write_head;
+    }
 
-    for (read = 0; read < frame_len; read++, write++)
+    size_t size = buffer_size_for(queued + len);
+    if (size == 0 || size > connection->buf_limit)
+    {
+        errno = EWOULDBLOCK;
+        return -1;
+    }
+    if (size <= connection->write_buf_size)
     {
-        uint8_t b;
-        if (read >= 2 && read < 6)
+        // Doubling is enough, e.g. when only a wrap prevents the frame
+        // from fitting.
+        size = connection->write_buf_size << 1;
+        if (size > connection->buf_limit)
         {
-            b = ((uint8_t*) &payload_length_bytes)[read - 2];
+            errno = EWOULDBLOCK;
+            return -1;
         }
-        else
+    }
+
+    uint8_t* write_buf = buffer_get(size);
+    if (write_buf == NULL) return -1;
+
+    if (connection->write_wrap != 0)
+    {
+        size_t first = connection->write_wrap - connection->write_head;
+        memcpy(write_buf,
+               &connection->write_buf[connection->write_head],
+               first);
+        memcpy(&write_buf[first],
+               connection->write_buf,
+               connection->write_tail);
+    }
+    else if (queued > 0)
+    {
+        memcpy(write_buf,
+               &connection->write_buf[connection->write_head],
+               queued);
+    }
+
+    buffer_put(connection->write_buf, connection->write_buf_size);
+
+    connection->write_buf = write_buf;
+    connection->write_buf_size = size;
+    connection->write_head = 0;
+    connection->write_tail = queued;
+    connection->write_wrap = 0;
+
+    return 0;
+}
+
+/*
+ * Reserve `len` contiguous bytes at the tail of the write buffer
+ * without growing it.
+ *
+ * If there is not enough room after the tail but there is before the head
+ * the buffer wraps, leaving the unused end to be skipped when flushing.
+ *
+ * Returns a pointer to the reserved bytes or NULL if there is not enough room.
+ */
+static uint8_t* mdr_frameconn_reserve_write_in_place(
+        mdr_frameconn_t* connection,
+        size_t len)
+{
+    size_t offset;
+
+    if (connection->write_wrap != 0)
+    {
+        if (connection->write_head - connection->write_tail < len)
         {
-            b = frame_bytes[read];
+            return NULL;
         }
 
-        switch (b)
-        {
-            case FRAME_START_BYTE:
-            case FRAME_ESCAPE_BYTE:
-            case FRAME_END_BYTE:
-                ENSURE_ESCAPED_BUFFER(2);
+        offset = connection->write_tail;
+    }
+    else if (connection->write_buf_size - connection->write_tail >= len)
+    {
+        offset = connection->write_tail;
+    }
+    else if (connection->write_head >= len)
+    {
+        connection->write_wrap = connection->write_tail;
+        offset = 0;
+    }
+    else
+    {
+        return NULL;
+    }
 
-                escaped[write] = FRAME_ESCAPE_BYTE;
-                write++;
-                escaped[write] = b & ~FRAME_ESCAPE_MASK;
+    connection->write_tail = offset + len;
 
-                break;
+    return &connection->write_buf[offset];
+}
 
-            default:
-                ENSURE_ESCAPED_BUFFER(1);
+/*
+ * Reserve `len` contiguous bytes at the tail of the write buffer,
+ * growing it up to the buffer limit if needed.
+ *
+ * Returns a pointer to the reserved bytes or NULL and sets errno if there
+ * is not enough room.
+ */
+static uint8_t* mdr_frameconn_reserve_write(mdr_frameconn_t* connection,
+                                            size_t len)
+{
+    uint8_t* reserved = mdr_frameconn_reserve_write_in_place(connection, len);
+    if (reserved != NULL) return reserved;
 
-                escaped[write] = b;
-                break;
-        }
+    if (mdr_frameconn_grow_write(connection, len) < 0)
+    {
+        return NULL;
     }
 
-    ENSURE_ESCAPED_BUFFER(1);
+    return mdr_frameconn_reserve_write_in_place(connection, len);
+}
+
+/*
+ * Escape a frame into the free space of the write buffer.
+ *
+ * The escaped length is computed before anything is written, if the frame
+ * does not fit the write buffer is left untouched.
+ *
+ * Returns 0 on success, returns -1 and sets errno on error, EWOULDBLOCK if
+ * there is not enough room or EMSGSIZE if the frame can never fit.
+ */
+static int mdr_frameconn_escape_frame(mdr_frameconn_t* connection,
+                                      mdr_frame_t* frame)
+{
+    uint8_t header[FRAME_HEADER_LEN];
+    header[0] = frame->data_type;
+    header[1] = frame->sequence_id;
+    uint32_t payload_length_bytes = htonl(frame->payload_length);
+    memcpy(&header[2], &payload_length_bytes, sizeof(uint32_t));
+
+    // The checksum immediately follows the payload.
+    uint8_t* body = mdr_frame_payload(frame);
+    size_t body_len = frame->payload_length + 1;
+
+    size_t escaped_len = 2
+                       + escape_len(header, FRAME_HEADER_LEN)
+                       + escape_len(body, body_len);
+
+    if (escaped_len > connection->buf_limit)
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    // It may be possible to write some bytes and buffer the rest
+    // but it's not possible to know if enough bytes can be sent
+    // right away. So instead EWOULDBLOCK is returned if the frame
+    // doesn't fit.
+    uint8_t* escaped = mdr_frameconn_reserve_write(connection, escaped_len);
+    if (escaped == NULL)
+    {
+        return -1;
+    }
+
+    size_t write = 0;
+
+    escaped[write] = FRAME_START_BYTE;
+    write++;
+
+    write += escape_bytes(&escaped[write], header, FRAME_HEADER_LEN);
+    write += escape_bytes(&escaped[write], body, body_len);
 
     escaped[write] = FRAME_END_BYTE;
     write++;
 
-    *escaped_len = write;
-    escaped = realloc(escaped, *escaped_len);
+    return 0;
+}
+
+/*
+ * Copy `len` already escaped bytes into the free space of the write buffer.
+ *
+ * Returns 0 on success, returns -1 and sets errno on error, EWOULDBLOCK if
+ * there is not enough room or EMSGSIZE if the bytes can never fit.
+ */
+static int mdr_frameconn_copy_escaped(mdr_frameconn_t* connection,
+                                      const uint8_t* bytes,
+                                      size_t len)
+{
+    if (len > connection->buf_limit)
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    uint8_t* escaped = mdr_frameconn_reserve_write(connection, len);
+    if (escaped == NULL)
+    {
+        return -1;
+    }
+
+    memcpy(escaped, bytes, len);
 
-    return escaped;
+    return 0;
 }
 
-int mdr_frameconn_write_frame(mdr_frameconn_t* connection,
+int mdr_frameconn_queue_frame(mdr_frameconn_t* connection,
                               mdr_frame_t* frame)
 {
+    if (mdr_frameconn_escape_frame(connection, frame) == 0)
+    {
+        return 0;
+    }
+
+    if (errno != EWOULDBLOCK)
+    {
+        return -1;
+    }
+
     // Try to flush the buffer to free up some room
-    // for the new frame if needed.
+    // for the new frame.
+    if (mdr_frameconn_flush_write(connection) < 0
+            && !(errno == EAGAIN || errno == EWOULDBLOCK))
     {
-        int result = mdr_frameconn_flush_write(connection);
-        if (result < 0 && !(errno == EAGAIN || errno == EINVAL))
-        {
-            return -1;
-        }
+        return -1;
     }
 
-    size_t escaped_len;
-    uint8_t* escaped = mdr_frameconn_escape_frame(frame, &escaped_len);
-    if (escaped == NULL) return -1;
+    return mdr_frameconn_escape_frame(connection, frame);
+}
 
-    if (FRAME_BUF_SIZE - connection->write_buf_len < escaped_len)
+int mdr_frameconn_queue_escaped(mdr_frameconn_t* connection,
+                                const uint8_t* bytes,
+                                size_t len)
+{
+    if (mdr_frameconn_copy_escaped(connection, bytes, len) == 0)
+    {
+        return 0;
+    }
+
+    if (errno != EWOULDBLOCK)
     {
-        // It may be possible to write some bytes and buffer the rest
-        // but it's not possible to know if enough bytes can be sent
-        // right away. So instead EWOULDBLOCK is returned.
-        free(escaped);
-        errno = EWOULDBLOCK;
         return -1;
     }
 
-    size_t written = 0;
-    while (written < escaped_len)
+    if (mdr_frameconn_flush_write(connection) < 0
+            && !(errno == EAGAIN || errno == EWOULDBLOCK))
     {
-        int bytes_written;
-write_bytes:
-        bytes_written = write(connection->sock,
-                              &escaped[written],
-                              escaped_len - written);
-        if (bytes_written < 0)
-        {
-            if (errno == EINTR)
-            {
-                goto write_bytes;
-            }
-            else if (errno == EAGAIN || errno == EWOULDBLOCK)
-            {
-                // Write blocked, buffer the remaining data and exit.
-                memcpy(&connection->write_buf[connection->write_buf_len],
-                       &escaped[written],
-                       escaped_len - written);
-                connection->write_buf_len += escaped_len - written;
-            }
-            free(escaped);
-            return -1;
-        }
+        return -1;
+    }
 
-#ifdef __DEBUG
-        fprintf(stderr, "wrote %d bytes\n", bytes_written);
-        for (int i = 0; i < bytes_written; i++)
-        {
-            fprintf(stderr, "%02x ", escaped[written + i]);
-        }
-        fprintf(stderr, "\n");
-#endif
+    return mdr_frameconn_copy_escaped(connection, bytes, len);
+}
 
-        written += bytes_written;
+int mdr_frameconn_write_frame(mdr_frameconn_t* connection,
+                              mdr_frame_t* frame)
+{
+    if (mdr_frameconn_queue_frame(connection, frame) < 0)
+    {
+        return -1;
     }
 
-    free(escaped);
+    // The frame is buffered at this point, if the socket would block
+    // the rest is sent by a later flush.
+    if (mdr_frameconn_flush_write(connection) < 0
+            && !(errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+        return -1;
+    }
 
     return 0;
 }
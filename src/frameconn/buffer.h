@@ -0,0 +1,156 @@
+/*
+ * libmdr - MDR protocol library
+ *
+ *  Copyright (C) 2021 Andreas Olofsson
+ *
+ *
+ * This file is part of libmdr.
+ *
+ * libmdr is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libmdr is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libmdr. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __MDR_FRAMECONN_BUFFER_H__
+#define __MDR_FRAMECONN_BUFFER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+/*
+ * Connection I/O buffers are power-of-two sized between these limits.
+ */
+#define BUFFER_MIN_SIZE ((size_t) 512)
+#define BUFFER_MAX_SIZE ((size_t) 1 << 20)
+
+/*
+ * Number of size classes kept in the slab, one per power of two.
+ */
+#define BUFFER_SLAB_NUM_CLASSES 12
+
+/*
+ * Maximum number of idle buffers kept per size class,
+ * shared by all connections.
+ */
+#define BUFFER_SLAB_DEPTH 16
+
+typedef struct buffer_slab_entry buffer_slab_entry_t;
+
+/*
+ * An idle buffer, the storage of the buffer is reused as a list node.
+ */
+struct buffer_slab_entry
+{
+    buffer_slab_entry_t* next;
+};
+
+static pthread_mutex_t buffer_slab_lock = PTHREAD_MUTEX_INITIALIZER;
+static buffer_slab_entry_t* buffer_slab[BUFFER_SLAB_NUM_CLASSES];
+static int buffer_slab_count[BUFFER_SLAB_NUM_CLASSES];
+
+/*
+ * Round `size` up to a valid buffer size.
+ *
+ * Returns 0 if `size` is larger than BUFFER_MAX_SIZE.
+ */
+static size_t buffer_size_for(size_t size)
+{
+    size_t buffer_size = BUFFER_MIN_SIZE;
+
+    while (buffer_size < size)
+    {
+        if (buffer_size >= BUFFER_MAX_SIZE) return 0;
+        buffer_size <<= 1;
+    }
+
+    return buffer_size;
+}
+
+static int buffer_slab_class(size_t size)
+{
+    int class = 0;
+
+    for (size_t class_size = BUFFER_MIN_SIZE;
+         class_size < size;
+         class_size <<= 1)
+    {
+        class++;
+    }
+
+    return class;
+}
+
+/*
+ * Get a buffer of `size` bytes, which must be a valid buffer size,
+ * reusing an idle one if there is any.
+ *
+ * Returns NULL and sets errno on error.
+ */
+static uint8_t* buffer_get(size_t size)
+{
+    int class = buffer_slab_class(size);
+    buffer_slab_entry_t* entry = NULL;
+
+    if (class < BUFFER_SLAB_NUM_CLASSES)
+    {
+        pthread_mutex_lock(&buffer_slab_lock);
+
+        entry = buffer_slab[class];
+        if (entry != NULL)
+        {
+            buffer_slab[class] = entry->next;
+            buffer_slab_count[class]--;
+        }
+
+        pthread_mutex_unlock(&buffer_slab_lock);
+    }
+
+    if (entry != NULL) return (uint8_t*) entry;
+
+    return malloc(size);
+}
+
+/*
+ * Give a buffer of `size` bytes back to the slab, or free it
+ * if the slab is full.
+ */
+static void buffer_put(uint8_t* buffer, size_t size)
+{
+    if (buffer == NULL) return;
+
+    int class = buffer_slab_class(size);
+
+    if (class < BUFFER_SLAB_NUM_CLASSES)
+    {
+        pthread_mutex_lock(&buffer_slab_lock);
+
+        if (buffer_slab_count[class] < BUFFER_SLAB_DEPTH)
+        {
+            void* storage = buffer;
+            buffer_slab_entry_t* entry = storage;
+
+            entry->next = buffer_slab[class];
+            buffer_slab[class] = entry;
+            buffer_slab_count[class]++;
+
+            buffer = NULL;
+        }
+
+        pthread_mutex_unlock(&buffer_slab_lock);
+    }
+
+    free(buffer);
+}
+
+#endif /* __MDR_FRAMECONN_BUFFER_H__ */
@@ -0,0 +1,213 @@
+/*
+ * libmdr - MDR protocol library
+ *
+ *  Copyright (C) 2021 Andreas Olofsson
+ *
+ *
+ * This file is part of libmdr.
+ *
+ * libmdr is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libmdr is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libmdr. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __MDR_FRAMECONN_ESCAPE_H__
+#define __MDR_FRAMECONN_ESCAPE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define ESCAPE_HAVE_AVX2
+#endif
+
+#define FRAME_START_BYTE  ((uint8_t) 0x3e)
+#define FRAME_ESCAPE_BYTE ((uint8_t) 0x3d)
+#define FRAME_END_BYTE    ((uint8_t) 0x3c)
+#define FRAME_ESCAPE_MASK ((uint8_t) 0x10)
+
+/*
+ * Bytes that have to be escaped on the wire are the start, escape and
+ * end bytes, 0x3c - 0x3e.
+ */
+#define IS_SPECIAL_BYTE(b) \
+    ((b) == FRAME_START_BYTE \
+  || (b) == FRAME_ESCAPE_BYTE \
+  || (b) == FRAME_END_BYTE)
+
+#define SWAR_ONES  ((uint64_t) 0x0101010101010101ull)
+#define SWAR_HIGHS ((uint64_t) 0x8080808080808080ull)
+#define SWAR_HAS_ZERO(v) (((v) - SWAR_ONES) & ~(v) & SWAR_HIGHS)
+#define SWAR_HAS_BYTE(v, b) SWAR_HAS_ZERO((v) ^ (SWAR_ONES * (b)))
+
+/*
+ * Portable fallback, tests eight bytes at a time using word arithmetic.
+ */
+static size_t escape_find_special_swar(const uint8_t* bytes, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t))
+    {
+        uint64_t v;
+        memcpy(&v, &bytes[i], sizeof(uint64_t));
+
+        if (SWAR_HAS_BYTE(v, FRAME_START_BYTE)
+                | SWAR_HAS_BYTE(v, FRAME_ESCAPE_BYTE)
+                | SWAR_HAS_BYTE(v, FRAME_END_BYTE))
+        {
+            break;
+        }
+    }
+
+    for (; i < len; i++)
+    {
+        if (IS_SPECIAL_BYTE(bytes[i])) return i;
+    }
+
+    return len;
+}
+
+#if defined(__SSE2__)
+static size_t escape_find_special_sse2(const uint8_t* bytes, size_t len)
+{
+    const __m128i start = _mm_set1_epi8(FRAME_START_BYTE);
+    const __m128i escape = _mm_set1_epi8(FRAME_ESCAPE_BYTE);
+    const __m128i end = _mm_set1_epi8(FRAME_END_BYTE);
+
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) &bytes[i]);
+        __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, start),
+                             _mm_cmpeq_epi8(v, escape)),
+                _mm_cmpeq_epi8(v, end));
+
+        int mask = _mm_movemask_epi8(special);
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+
+    return i + escape_find_special_swar(&bytes[i], len - i);
+}
+#endif
+
+#if defined(ESCAPE_HAVE_AVX2)
+__attribute__((target("avx2")))
+static size_t escape_find_special_avx2(const uint8_t* bytes, size_t len)
+{
+    const __m256i start = _mm256_set1_epi8(FRAME_START_BYTE);
+    const __m256i escape = _mm256_set1_epi8(FRAME_ESCAPE_BYTE);
+    const __m256i end = _mm256_set1_epi8(FRAME_END_BYTE);
+
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*) &bytes[i]);
+        __m256i special = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, start),
+                                _mm256_cmpeq_epi8(v, escape)),
+                _mm256_cmpeq_epi8(v, end));
+
+        unsigned int mask = _mm256_movemask_epi8(special);
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+
+    return i + escape_find_special_swar(&bytes[i], len - i);
+}
+#endif
+
+/*
+ * Find the first byte which is a start, escape or end byte.
+ *
+ * Returns the index of the byte or `len` if there is none.
+ */
+static size_t escape_find_special(const uint8_t* bytes, size_t len)
+{
+#if defined(ESCAPE_HAVE_AVX2)
+    if (len >= 32 && __builtin_cpu_supports("avx2"))
+    {
+        return escape_find_special_avx2(bytes, len);
+    }
+#endif
+#if defined(__SSE2__)
+    if (len >= 16)
+    {
+        return escape_find_special_sse2(bytes, len);
+    }
+#endif
+    return escape_find_special_swar(bytes, len);
+}
+
+/*
+ * Get the number of bytes `len` bytes occupy once escaped.
+ */
+static size_t escape_len(const uint8_t* bytes, size_t len)
+{
+    size_t escaped_len = len;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        i += escape_find_special(&bytes[i], len - i);
+        if (i < len) escaped_len++;
+    }
+
+    return escaped_len;
+}
+
+/*
+ * Escape `len` bytes into `out`, bulk-copying the runs between bytes
+ * that need escaping.
+ *
+ * `out` must have room for `escape_len(bytes, len)` bytes.
+ *
+ * Returns the number of bytes written.
+ */
+static size_t escape_bytes(uint8_t* out, const uint8_t* bytes, size_t len)
+{
+    size_t read = 0, write = 0;
+
+    while (read < len)
+    {
+        size_t run = escape_find_special(&bytes[read], len - read);
+
+        memcpy(&out[write], &bytes[read], run);
+        read += run;
+        write += run;
+
+        if (read < len)
+        {
+            out[write] = FRAME_ESCAPE_BYTE;
+            out[write + 1] = bytes[read] & ~FRAME_ESCAPE_MASK;
+            read++;
+            write += 2;
+        }
+    }
+
+    return write;
+}
+
+#endif /* __MDR_FRAMECONN_ESCAPE_H__ */
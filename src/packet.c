@@ -31,193 +31,551 @@
 #include "packet/play.h"
 #include "packet/system.h"
 
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <errno.h>
 
+/*
+ * Size of the per-thread scratch arena packets are measured in,
+ * larger packets are measured in temporary heap arenas.
+ */
+#define PACKET_SCRATCH_SIZE 2048
+
+/*
+ * Largest arena a single packet is decoded into.
+ */
+#define PACKET_MAX_DECODED_SIZE ((size_t) 1 << 20)
+
+static _Thread_local union
+{
+    max_align_t align;
+    uint8_t bytes[PACKET_SCRATCH_SIZE];
+}
+packet_scratch;
+
+/*
+ * The codec of a packet type and how replies of the type are matched.
+ */
+typedef struct
+{
+    mdr_packet_t* (*decode)(mdr_frame_t*, parse_arena_t*);
+    mdr_frame_t* (*encode)(mdr_packet_t*, mdr_frame_pool_t*);
+    size_t (*size)(mdr_packet_t*);
+    void (*wire)(mdr_packet_t*, wire_t*);
+
+    /*
+     * Get the type specific extra parameter reply specifiers are matched
+     * against, NULL if any packet of the type matches.
+     */
+    uint8_t (*extra)(mdr_packet_t*);
+    // Offset of the byte `extra` returns in the payload of a frame.
+    uint8_t extra_offset;
+
+    // Packets of the type only query the device.
+    bool get;
+    // Packets of the type change a setting of the device, identified by
+    // the type and extra parameter.
+    bool set;
+}
+packet_descriptor_t;
+
+#define MATCH_FIELD(name, field) \
+    static uint8_t extra_##name(mdr_packet_t* packet) \
+    { \
+        return packet->data.name.field; \
+    }
+
+MATCH_FIELD(connect_ret_device_info, inquired_type)
+MATCH_FIELD(common_ret_battery_level, inquired_type)
+MATCH_FIELD(common_ntfy_battery_level, inquired_type)
+MATCH_FIELD(common_ret_connection_status, inquired_type)
+MATCH_FIELD(common_ntfy_connection_status, inquired_type)
+MATCH_FIELD(eqebb_ret_capability, inquired_type)
+MATCH_FIELD(eqebb_ret_param, inquired_type)
+MATCH_FIELD(eqebb_set_param, inquired_type)
+MATCH_FIELD(eqebb_ntfy_param, inquired_type)
+MATCH_FIELD(ncasm_ret_param, inquired_type)
+MATCH_FIELD(ncasm_set_param, inquired_type)
+MATCH_FIELD(ncasm_ntfy_param, inquired_type)
+MATCH_FIELD(play_ret_param, detailed_data_type)
+MATCH_FIELD(play_set_param, detailed_data_type)
+MATCH_FIELD(play_ntfy_param, detailed_data_type)
+MATCH_FIELD(system_ret_capability, inquired_type)
+MATCH_FIELD(system_ret_param, inquired_type)
+MATCH_FIELD(system_set_param, inquired_type)
+MATCH_FIELD(system_ntfy_param, inquired_type)
+
+#undef MATCH_FIELD
+
+#define FAMILY(family) \
+    .decode = mdr_packet_##family##_from_frame, \
+    .encode = mdr_packet_##family##_to_frame, \
+    .size = mdr_packet_##family##_encoded_size, \
+    .wire = mdr_packet_##family##_to_wire
+
+#define MATCH(name, offset) \
+    .extra = extra_##name, \
+    .extra_offset = offset
+
+/*
+ * Indexed by packet type, unsupported types have no codec.
+ */
+static const packet_descriptor_t packet_descriptors[256] = {
+    [MDR_PACKET_CONNECT_GET_PROTOCOL_INFO]    = { FAMILY(connect), .get = true },
+    [MDR_PACKET_CONNECT_RET_PROTOCOL_INFO]    = { FAMILY(connect) },
+    [MDR_PACKET_CONNECT_GET_DEVICE_INFO]      = { FAMILY(connect), .get = true },
+    [MDR_PACKET_CONNECT_RET_DEVICE_INFO]      = { FAMILY(connect),
+                                                  MATCH(connect_ret_device_info, 1) },
+    [MDR_PACKET_CONNECT_GET_SUPPORT_FUNCTION] = { FAMILY(connect), .get = true },
+    [MDR_PACKET_CONNECT_RET_SUPPORT_FUNCTION] = { FAMILY(connect) },
+
+    [MDR_PACKET_COMMON_GET_BATTERY_LEVEL]      = { FAMILY(common), .get = true },
+    [MDR_PACKET_COMMON_RET_BATTERY_LEVEL]      = { FAMILY(common),
+                                                   MATCH(common_ret_battery_level, 1) },
+    [MDR_PACKET_COMMON_NTFY_BATTERY_LEVEL]     = { FAMILY(common),
+                                                   MATCH(common_ntfy_battery_level, 1) },
+    [MDR_PACKET_COMMON_SET_POWER_OFF]          = { FAMILY(common) },
+    [MDR_PACKET_COMMON_GET_CONNECTION_STATUS]  = { FAMILY(common), .get = true },
+    [MDR_PACKET_COMMON_RET_CONNECTION_STATUS]  = { FAMILY(common),
+                                                   MATCH(common_ret_connection_status, 1) },
+    [MDR_PACKET_COMMON_NTFY_CONNECTION_STATUS] = { FAMILY(common),
+                                                   MATCH(common_ntfy_connection_status, 1) },
+
+    [MDR_PACKET_EQEBB_GET_CAPABILITY] = { FAMILY(eqebb), .get = true },
+    [MDR_PACKET_EQEBB_RET_CAPABILITY] = { FAMILY(eqebb),
+                                          MATCH(eqebb_ret_capability, 1) },
+    [MDR_PACKET_EQEBB_GET_PARAM]      = { FAMILY(eqebb), .get = true },
+    [MDR_PACKET_EQEBB_RET_PARAM]      = { FAMILY(eqebb),
+                                          MATCH(eqebb_ret_param, 1) },
+    [MDR_PACKET_EQEBB_SET_PARAM]      = { FAMILY(eqebb),
+                                          MATCH(eqebb_set_param, 1), .set = true },
+    [MDR_PACKET_EQEBB_NTFY_PARAM]     = { FAMILY(eqebb),
+                                          MATCH(eqebb_ntfy_param, 1) },
+
+    [MDR_PACKET_NCASM_GET_PARAM]  = { FAMILY(ncasm), .get = true },
+    [MDR_PACKET_NCASM_RET_PARAM]  = { FAMILY(ncasm),
+                                      MATCH(ncasm_ret_param, 1) },
+    [MDR_PACKET_NCASM_SET_PARAM]  = { FAMILY(ncasm),
+                                      MATCH(ncasm_set_param, 1), .set = true },
+    [MDR_PACKET_NCASM_NTFY_PARAM] = { FAMILY(ncasm),
+                                      MATCH(ncasm_ntfy_param, 1) },
+
+    [MDR_PACKET_PLAY_GET_PARAM]  = { FAMILY(play), .get = true },
+    [MDR_PACKET_PLAY_RET_PARAM]  = { FAMILY(play),
+                                     MATCH(play_ret_param, 2) },
+    [MDR_PACKET_PLAY_SET_PARAM]  = { FAMILY(play),
+                                     MATCH(play_set_param, 2), .set = true },
+    [MDR_PACKET_PLAY_NTFY_PARAM] = { FAMILY(play),
+                                     MATCH(play_ntfy_param, 2) },
+
+    [MDR_PACKET_SYSTEM_GET_CAPABILITY] = { FAMILY(system), .get = true },
+    [MDR_PACKET_SYSTEM_RET_CAPABILITY] = { FAMILY(system),
+                                           MATCH(system_ret_capability, 1) },
+    [MDR_PACKET_SYSTEM_GET_PARAM]      = { FAMILY(system), .get = true },
+    [MDR_PACKET_SYSTEM_RET_PARAM]      = { FAMILY(system),
+                                           MATCH(system_ret_param, 1) },
+    [MDR_PACKET_SYSTEM_SET_PARAM]      = { FAMILY(system),
+                                           MATCH(system_set_param, 1), .set = true },
+    [MDR_PACKET_SYSTEM_NTFY_PARAM]     = { FAMILY(system),
+                                           MATCH(system_ntfy_param, 1) },
+};
+
+#undef FAMILY
+#undef MATCH
+
 void mdr_packet_free(mdr_packet_t* packet)
 {
-    if (packet == NULL)
-        return;
+    free(packet);
+}
 
-    switch (packet->type)
+static mdr_packet_t* decode(mdr_frame_t* frame, parse_arena_t* arena)
+{
+    if (frame->data_type != MDR_FRAME_DATA_TYPE_DATA_MDR)
     {
-        case MDR_PACKET_CONNECT_GET_PROTOCOL_INFO:
-        case MDR_PACKET_CONNECT_RET_PROTOCOL_INFO:
-        case MDR_PACKET_CONNECT_GET_DEVICE_INFO:
-        case MDR_PACKET_CONNECT_RET_DEVICE_INFO:
-        case MDR_PACKET_CONNECT_GET_SUPPORT_FUNCTION:
-        case MDR_PACKET_CONNECT_RET_SUPPORT_FUNCTION:
-            mdr_packet_connect_free(packet);
+        errno = MDR_E_INVALID_PACKET;
+        return NULL;
+    }
 
-            break;
+    if (frame->payload_length < 1)
+    {
+        errno = MDR_E_INVALID_FRAME;
+        return NULL;
+    }
 
-        case MDR_PACKET_COMMON_GET_BATTERY_LEVEL:
-        case MDR_PACKET_COMMON_RET_BATTERY_LEVEL:
-        case MDR_PACKET_COMMON_NTFY_BATTERY_LEVEL:
-        case MDR_PACKET_COMMON_SET_POWER_OFF:
-        case MDR_PACKET_COMMON_GET_CONNECTION_STATUS:
-        case MDR_PACKET_COMMON_RET_CONNECTION_STATUS:
-        case MDR_PACKET_COMMON_NTFY_CONNECTION_STATUS:
-            mdr_packet_common_free(packet);
+    const packet_descriptor_t* descriptor
+            = &packet_descriptors[mdr_frame_payload(frame)[0]];
+    if (descriptor->decode == NULL)
+    {
+        errno = MDR_E_INVALID_FRAME;
+        return NULL;
+    }
 
-            break;
+    return descriptor->decode(frame, arena);
+}
 
-        case MDR_PACKET_EQEBB_GET_CAPABILITY:
-        case MDR_PACKET_EQEBB_RET_CAPABILITY:
-        case MDR_PACKET_EQEBB_GET_PARAM:
-        case MDR_PACKET_EQEBB_RET_PARAM:
-        case MDR_PACKET_EQEBB_SET_PARAM:
-        case MDR_PACKET_EQEBB_NTFY_PARAM:
-            mdr_packet_eqebb_free(packet);
+/*
+ * Get the decoded size of the packet in `frame`, see
+ * `mdr_packet_decoded_size`.
+ *
+ * `self_contained` is set if the packet left in the scratch arena points
+ * to nothing else, not even an empty string or array, and can be copied.
+ */
+static size_t measure(mdr_frame_t* frame, bool* self_contained)
+{
+    parse_arena_t arena = {
+        .base = packet_scratch.bytes,
+        .size = PACKET_SCRATCH_SIZE,
+        .used = 0,
+        .borrow = false,
+        .allocations = 0,
+    };
 
-            break;
+    *self_contained = false;
 
-        case MDR_PACKET_NCASM_GET_PARAM:
-        case MDR_PACKET_NCASM_SET_PARAM:
-        case MDR_PACKET_NCASM_RET_PARAM:
-        case MDR_PACKET_NCASM_NTFY_PARAM:
-            mdr_packet_ncasm_free(packet);
+    if (decode(frame, &arena) != NULL)
+    {
+        *self_contained = arena.allocations == 1;
+        return arena.used;
+    }
+    if (errno != ENOBUFS) return 0;
 
-            break;
+    for (size_t size = PACKET_SCRATCH_SIZE << 1;
+         size <= PACKET_MAX_DECODED_SIZE;
+         size <<= 1)
+    {
+        arena.base = malloc(size);
+        arena.size = size;
+        arena.used = 0;
+        arena.borrow = false;
+        arena.allocations = 0;
+        if (arena.base == NULL) return 0;
+
+        mdr_packet_t* packet = decode(frame, &arena);
+        free(arena.base);
+
+        if (packet != NULL) return arena.used;
+        if (errno != ENOBUFS) return 0;
+    }
 
-        case MDR_PACKET_PLAY_GET_PARAM:
-        case MDR_PACKET_PLAY_RET_PARAM:
-        case MDR_PACKET_PLAY_SET_PARAM:
-        case MDR_PACKET_PLAY_NTFY_PARAM:
-            mdr_packet_play_free(packet);
+    errno = ENOBUFS;
+    return 0;
+}
 
-            break;
+size_t mdr_packet_decoded_size(mdr_frame_t* frame)
+{
+    bool self_contained;
+    return measure(frame, &self_contained);
+}
 
-        case MDR_PACKET_SYSTEM_GET_CAPABILITY:
-        case MDR_PACKET_SYSTEM_RET_CAPABILITY:
-        case MDR_PACKET_SYSTEM_GET_PARAM:
-        case MDR_PACKET_SYSTEM_RET_PARAM:
-        case MDR_PACKET_SYSTEM_SET_PARAM:
-        case MDR_PACKET_SYSTEM_NTFY_PARAM:
-            mdr_packet_system_free(packet);
+mdr_packet_t* mdr_packet_from_frame(mdr_frame_t* frame)
+{
+    bool self_contained;
+    size_t size = measure(frame, &self_contained);
+    if (size == 0) return NULL;
+
+    void* block = malloc(size);
+    if (block == NULL) return NULL;
 
-            break;
+    // A packet without any strings or arrays has nothing pointing into
+    // the scratch arena, and can be copied instead of decoded again.
+    if (self_contained)
+    {
+        memcpy(block, packet_scratch.bytes, size);
+        return block;
     }
 
-    free(packet);
+    mdr_packet_t* packet = mdr_packet_from_frame_into(frame, block, size);
+    if (packet == NULL)
+    {
+        free(block);
+    }
+
+    return packet;
 }
 
-mdr_packet_t* mdr_packet_from_frame(mdr_frame_t* frame)
+mdr_packet_t* mdr_packet_from_frame_into(mdr_frame_t* frame,
+                                         void* buf,
+                                         size_t size)
 {
-    if (frame->data_type != MDR_FRAME_DATA_TYPE_DATA_MDR)
+    parse_arena_t arena = {
+        .base = buf,
+        .size = size,
+        .used = 0,
+        .borrow = false,
+        .allocations = 0,
+    };
+
+    return decode(frame, &arena);
+}
+
+mdr_packet_t* mdr_packet_view_from_frame(mdr_frame_t* frame,
+                                         void* buf,
+                                         size_t size)
+{
+    parse_arena_t arena = {
+        .base = buf,
+        .size = size,
+        .used = 0,
+        .borrow = true,
+        .allocations = 0,
+    };
+
+    return decode(frame, &arena);
+}
+
+mdr_frame_t* mdr_packet_to_frame(mdr_packet_t* packet)
+{
+    return mdr_packet_to_frame_from_pool(packet, NULL);
+}
+
+mdr_frame_t* mdr_packet_to_frame_from_pool(mdr_packet_t* packet,
+                                           mdr_frame_pool_t* pool)
+{
+    if ((unsigned int) packet->type > 0xff
+            || packet_descriptors[packet->type].encode == NULL)
     {
-        errno = MDR_E_INVALID_PACKET;
+        errno = EINVAL;
         return NULL;
     }
 
-    if (frame->payload_length < 1)
+    return packet_descriptors[packet->type].encode(packet, pool);
+}
+
+size_t mdr_packet_encoded_size(mdr_packet_t* packet)
+{
+    if ((unsigned int) packet->type > 0xff
+            || packet_descriptors[packet->type].size == NULL)
     {
-        errno = MDR_E_INVALID_FRAME;
-        return NULL;
+        errno = EINVAL;
+        return 0;
     }
 
-    switch (mdr_frame_payload(frame)[0])
-    {
-        case MDR_PACKET_CONNECT_GET_PROTOCOL_INFO:
-        case MDR_PACKET_CONNECT_RET_PROTOCOL_INFO:
-        case MDR_PACKET_CONNECT_GET_DEVICE_INFO:
-        case MDR_PACKET_CONNECT_RET_DEVICE_INFO:
-        case MDR_PACKET_CONNECT_GET_SUPPORT_FUNCTION:
-        case MDR_PACKET_CONNECT_RET_SUPPORT_FUNCTION:
-            return mdr_packet_connect_from_frame(frame);
-
-        case MDR_PACKET_COMMON_GET_BATTERY_LEVEL:
-        case MDR_PACKET_COMMON_RET_BATTERY_LEVEL:
-        case MDR_PACKET_COMMON_NTFY_BATTERY_LEVEL:
-        case MDR_PACKET_COMMON_SET_POWER_OFF:
-        case MDR_PACKET_COMMON_GET_CONNECTION_STATUS:
-        case MDR_PACKET_COMMON_RET_CONNECTION_STATUS:
-        case MDR_PACKET_COMMON_NTFY_CONNECTION_STATUS:
-            return mdr_packet_common_from_frame(frame);
-
-        case MDR_PACKET_EQEBB_GET_CAPABILITY:
-        case MDR_PACKET_EQEBB_RET_CAPABILITY:
-        case MDR_PACKET_EQEBB_GET_PARAM:
-        case MDR_PACKET_EQEBB_RET_PARAM:
-        case MDR_PACKET_EQEBB_SET_PARAM:
-        case MDR_PACKET_EQEBB_NTFY_PARAM:
-            return mdr_packet_eqebb_from_frame(frame);
-
-        case MDR_PACKET_NCASM_GET_PARAM:
-        case MDR_PACKET_NCASM_SET_PARAM:
-        case MDR_PACKET_NCASM_RET_PARAM:
-        case MDR_PACKET_NCASM_NTFY_PARAM:
-            return mdr_packet_ncasm_from_frame(frame);
-
-        case MDR_PACKET_PLAY_GET_PARAM:
-        case MDR_PACKET_PLAY_RET_PARAM:
-        case MDR_PACKET_PLAY_SET_PARAM:
-        case MDR_PACKET_PLAY_NTFY_PARAM:
-            return mdr_packet_play_from_frame(frame);
-
-        case MDR_PACKET_SYSTEM_GET_CAPABILITY:
-        case MDR_PACKET_SYSTEM_RET_CAPABILITY:
-        case MDR_PACKET_SYSTEM_GET_PARAM:
-        case MDR_PACKET_SYSTEM_RET_PARAM:
-        case MDR_PACKET_SYSTEM_SET_PARAM:
-        case MDR_PACKET_SYSTEM_NTFY_PARAM:
-            return mdr_packet_system_from_frame(frame);
-
-        default:
-            errno = MDR_E_INVALID_FRAME;
-            return NULL;
+    return packet_descriptors[packet->type].size(packet);
+}
+
+/*
+ * Encode a frame with a payload of `length` bytes, written by either
+ * encoding `packet` or copying `payload`.
+ */
+static size_t encode_wire(mdr_packet_t* packet,
+                          const uint8_t* payload,
+                          size_t length,
+                          uint8_t sequence_id,
+                          uint8_t* buf,
+                          size_t size)
+{
+    if (length > UINT32_MAX)
+    {
+        errno = EMSGSIZE;
+        return 0;
     }
+
+    wire_t wire = {
+        .out = buf,
+        .cap = size,
+        .len = 0,
+        .checksum = 0,
+        .overflow = false,
+    };
+
+    wire_put_delimiter(&wire, FRAME_START_BYTE);
+
+    wire_put(&wire, MDR_FRAME_DATA_TYPE_DATA_MDR);
+    wire_put(&wire, sequence_id);
+    wire_put(&wire, length >> 24);
+    wire_put(&wire, length >> 16);
+    wire_put(&wire, length >> 8);
+    wire_put(&wire, length);
+
+    if (packet != NULL)
+    {
+        packet_descriptors[packet->type].wire(packet, &wire);
+    }
+    else
+    {
+        wire_put_bytes(&wire, payload, length);
+    }
+
+    wire_put(&wire, wire.checksum);
+    wire_put_delimiter(&wire, FRAME_END_BYTE);
+
+    if (wire.overflow)
+    {
+        errno = ENOBUFS;
+        return 0;
+    }
+
+    return wire.len;
 }
 
-mdr_frame_t* mdr_packet_to_frame(mdr_packet_t* packet)
+size_t mdr_packet_encode_wire(mdr_packet_t* packet,
+                              uint8_t sequence_id,
+                              uint8_t* buf,
+                              size_t size)
+{
+    size_t length = mdr_packet_encoded_size(packet);
+    if (length == 0) return 0;
+
+    return encode_wire(packet, NULL, length, sequence_id, buf, size);
+}
+
+size_t mdr_packet_encode_wire_payload(const uint8_t* payload,
+                                      size_t length,
+                                      uint8_t sequence_id,
+                                      uint8_t* buf,
+                                      size_t size)
+{
+    if (length == 0)
+    {
+        errno = EINVAL;
+        return 0;
+    }
+
+    return encode_wire(NULL, payload, length, sequence_id, buf, size);
+}
+
+size_t mdr_packet_wire_set_sequence_id(uint8_t* wire,
+                                       size_t len,
+                                       uint8_t sequence_id)
+{
+    // Sequence ids are 0 or 1, which never have to be escaped, so the
+    // sequence id is always the third byte.
+    if (len < 2 + MDR_FRAME_EMPTY_LEN || sequence_id > 1 || wire[2] > 1)
+    {
+        errno = EINVAL;
+        return 0;
+    }
+
+    // The checksum is either the byte before the end byte or escaped,
+    // an escaped byte is never an escape byte itself.
+    size_t checksum_pos = len - 2;
+    uint8_t checksum = wire[checksum_pos];
+    if (wire[len - 3] == FRAME_ESCAPE_BYTE)
+    {
+        checksum_pos = len - 3;
+        checksum = wire[len - 2] | FRAME_ESCAPE_MASK;
+    }
+
+    checksum = checksum - wire[2] + sequence_id;
+    wire[2] = sequence_id;
+
+    if (IS_SPECIAL_BYTE(checksum))
+    {
+        wire[checksum_pos] = FRAME_ESCAPE_BYTE;
+        wire[checksum_pos + 1] = checksum & ~FRAME_ESCAPE_MASK;
+        wire[checksum_pos + 2] = FRAME_END_BYTE;
+        return checksum_pos + 3;
+    }
+
+    wire[checksum_pos] = checksum;
+    wire[checksum_pos + 1] = FRAME_END_BYTE;
+    return checksum_pos + 2;
+}
+
+bool mdr_packet_frame_matches(mdr_frame_t* frame,
+                              mdr_packet_type_t type,
+                              uint8_t extra)
+{
+    if (frame->data_type != MDR_FRAME_DATA_TYPE_DATA_MDR
+            || frame->payload_length < 1
+            || (unsigned int) type > 0xff)
+    {
+        return false;
+    }
+
+    uint8_t* payload = mdr_frame_payload(frame);
+    if (payload[0] != type)
+    {
+        return false;
+    }
+
+    const packet_descriptor_t* descriptor = &packet_descriptors[type];
+    if (descriptor->extra == NULL)
+    {
+        return true;
+    }
+
+    return frame->payload_length > descriptor->extra_offset
+        && payload[descriptor->extra_offset] == extra;
+}
+
+bool mdr_packet_frame_peek(mdr_frame_t* frame,
+                           mdr_packet_type_t* type,
+                           uint8_t* extra)
+{
+    if (frame->data_type != MDR_FRAME_DATA_TYPE_DATA_MDR
+            || frame->payload_length < 1)
+    {
+        return false;
+    }
+
+    uint8_t* payload = mdr_frame_payload(frame);
+    const packet_descriptor_t* descriptor = &packet_descriptors[payload[0]];
+
+    *type = payload[0];
+    if (descriptor->extra == NULL)
+    {
+        *extra = 0;
+        return true;
+    }
+
+    if (frame->payload_length <= descriptor->extra_offset)
+    {
+        return false;
+    }
+
+    *extra = payload[descriptor->extra_offset];
+    return true;
+}
+
+bool mdr_packet_type_is_get(mdr_packet_type_t type)
+{
+    return (unsigned int) type <= 0xff && packet_descriptors[type].get;
+}
+
+bool mdr_packet_type_is_set(mdr_packet_type_t type)
 {
-    switch (packet->type)
-    {
-        case MDR_PACKET_CONNECT_GET_PROTOCOL_INFO:
-        case MDR_PACKET_CONNECT_RET_PROTOCOL_INFO:
-        case MDR_PACKET_CONNECT_GET_DEVICE_INFO:
-        case MDR_PACKET_CONNECT_RET_DEVICE_INFO:
-        case MDR_PACKET_CONNECT_GET_SUPPORT_FUNCTION:
-        case MDR_PACKET_CONNECT_RET_SUPPORT_FUNCTION:
-            return mdr_packet_connect_to_frame(packet);
-
-        case MDR_PACKET_COMMON_GET_BATTERY_LEVEL:
-        case MDR_PACKET_COMMON_RET_BATTERY_LEVEL:
-        case MDR_PACKET_COMMON_NTFY_BATTERY_LEVEL:
-        case MDR_PACKET_COMMON_SET_POWER_OFF:
-        case MDR_PACKET_COMMON_GET_CONNECTION_STATUS:
-        case MDR_PACKET_COMMON_RET_CONNECTION_STATUS:
-        case MDR_PACKET_COMMON_NTFY_CONNECTION_STATUS:
-            return mdr_packet_common_to_frame(packet);
-
-        case MDR_PACKET_EQEBB_GET_CAPABILITY:
-        case MDR_PACKET_EQEBB_RET_CAPABILITY:
-        case MDR_PACKET_EQEBB_GET_PARAM:
-        case MDR_PACKET_EQEBB_RET_PARAM:
-        case MDR_PACKET_EQEBB_SET_PARAM:
-        case MDR_PACKET_EQEBB_NTFY_PARAM:
-            return mdr_packet_eqebb_to_frame(packet);
-
-        case MDR_PACKET_NCASM_GET_PARAM:
-        case MDR_PACKET_NCASM_SET_PARAM:
-        case MDR_PACKET_NCASM_RET_PARAM:
-        case MDR_PACKET_NCASM_NTFY_PARAM:
-            return mdr_packet_ncasm_to_frame(packet);
-
-        case MDR_PACKET_PLAY_GET_PARAM:
-        case MDR_PACKET_PLAY_RET_PARAM:
-        case MDR_PACKET_PLAY_SET_PARAM:
-        case MDR_PACKET_PLAY_NTFY_PARAM:
-            return mdr_packet_play_to_frame(packet);
-
-        case MDR_PACKET_SYSTEM_GET_CAPABILITY:
-        case MDR_PACKET_SYSTEM_RET_CAPABILITY:
-        case MDR_PACKET_SYSTEM_GET_PARAM:
-        case MDR_PACKET_SYSTEM_RET_PARAM:
-        case MDR_PACKET_SYSTEM_SET_PARAM:
-        case MDR_PACKET_SYSTEM_NTFY_PARAM:
-            return mdr_packet_system_to_frame(packet);
-    }
-
-    return NULL;
+    return (unsigned int) type <= 0xff && packet_descriptors[type].set;
+}
+
+bool mdr_packet_type_has_extra(mdr_packet_type_t type)
+{
+    return (unsigned int) type <= 0xff
+        && packet_descriptors[type].extra != NULL;
+}
+
+uint8_t mdr_packet_extra(mdr_packet_t* packet)
+{
+    if ((unsigned int) packet->type > 0xff)
+    {
+        return 0;
+    }
+
+    const packet_descriptor_t* descriptor = &packet_descriptors[packet->type];
+    if (descriptor->extra == NULL)
+    {
+        return 0;
+    }
+
+    return descriptor->extra(packet);
+}
+
+bool mdr_packet_matches(mdr_packet_t* packet,
+                        mdr_packet_type_t type,
+                        uint8_t extra)
+{
+    if (packet->type != type || (unsigned int) type > 0xff)
+    {
+        return false;
+    }
+
+    const packet_descriptor_t* descriptor = &packet_descriptors[packet->type];
+    if (descriptor->extra == NULL)
+    {
+        return descriptor->decode != NULL;
+    }
+
+    return descriptor->extra(packet) == extra;
 }
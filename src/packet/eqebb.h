@@ -22,404 +22,121 @@
 
 #include <errno.h>
 
-#include "./util.h"
-
-#include <mdr/errors.h>
-
-static void mdr_packet_eqebb_free(mdr_packet_t* packet)
-{
-    switch (packet->type)
-    {
-        case MDR_PACKET_EQEBB_GET_CAPABILITY:
-            break;
-
-        case MDR_PACKET_EQEBB_RET_CAPABILITY:
-#define PACKET_FIELD eqebb_ret_capability
-
-            switch (FIELD(inquired_type))
-            {
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ:
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE:
-                    FREE_FOR_EACH_IN_PACKET(
-                            eq.num_presets,
-                            eq.presets,
-                            mdr_packet_eqebb_capability_eq_preset_name_t,
-                            preset)
-
-                        free(preset->name);
-
-                    FREE_FOR_EACH_END
-
-                    FREE_FIELD(eq.presets)
-
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_EBB:
-                    break;
-            }
-
-            break;
-
-#undef PACKET_FIELD
-
-        case MDR_PACKET_EQEBB_GET_PARAM:
-            break;
-
-        case MDR_PACKET_EQEBB_RET_PARAM:
-        case MDR_PACKET_EQEBB_SET_PARAM:
-        case MDR_PACKET_EQEBB_NTFY_PARAM:
-#define PACKET_FIELD eqebb_ret_param
-
-            switch (FIELD(inquired_type))
-            {
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ:
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE:
-                    FREE_FIELD(eq.levels)
-
-                    break;
-
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_EBB:
-                    break;
-            }
-
-            break;
-
-#undef PACKET_FIELD
-
-        default:
-            break;
-    }
-}
-
-static mdr_packet_t* mdr_packet_eqebb_from_frame(mdr_frame_t* frame)
-{
-    PARSE_INIT(frame)
-
-    switch (mdr_frame_payload(frame)[0])
-    {
-        case MDR_PACKET_EQEBB_GET_CAPABILITY:
-#define PACKET_FIELD eqebb_get_capability
-
-            PARSE_ENUM_INTO_PACKET(inquired_type)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_INQUIRED_TYPE_EBB)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE)
-            PARSE_ENUM_END
-
-            PARSE_ENUM_INTO_PACKET(display_language)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_UNDEFINED_LANGUAGE)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_ENGLISH)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_FRENCH)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_GERMAN)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_SPANISH)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_ITALIAN)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_PORTUGUESE)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_DUTCH)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_SWEDISH)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_FINNISH)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_RUSSIAN)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_JAPANESE)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_SIMPLIFIED_CHINESE)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_BRAZILIAN_PORTUGUESE)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_TRADITIONAL_CHINESE)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_KOREAN)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_TURKISH)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_CHINESE)
-            PARSE_ENUM_END
-
-            break;
-
-#undef PACKET_FIELD
-
-        case MDR_PACKET_EQEBB_RET_CAPABILITY:
-#define PACKET_FIELD eqebb_ret_capability
-
-            PARSE_ENUM_INTO_PACKET(inquired_type)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_INQUIRED_TYPE_EBB)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE)
-            PARSE_ENUM_END
-
-            switch (FIELD(inquired_type))
-            {
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ:
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE:
-                    PARSE_BYTE_INTO_PACKET(eq.band_count)
-                    PARSE_BYTE_INTO_PACKET(eq.level_steps)
-                    PARSE_BYTE_INTO_PACKET(eq.num_presets)
-
-                    PARSE_FOR_EACH_IN_PACKET(
-                            eq.num_presets,
-                            eq.presets,
-                            mdr_packet_eqebb_capability_eq_preset_name_t,
-                            preset)
-
-                        PARSE_ENUM_INTO_VALUE(preset->preset_id)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_OFF)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_ROCK)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_POP)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_JAZZ)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_DANCE)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_EDM)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_R_AND_B_HIP_HOP)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_ACOUSTIC)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO8)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO9)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO10)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO11)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO12)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO13)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO14)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO15)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_BRIGHT)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_EXCITED)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_MELLOW)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RELAXED)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_VOCAL)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_TREBLE)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_BASS)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_SPEECH)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO24)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO25)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO26)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO27)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO28)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO29)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO30)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO31)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_CUSTOM)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING1)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING2)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING3)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING4)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING5)
-                            PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_UNSPECIFIED)
-                        PARSE_ENUM_END
-
-                        PARSE_BYTE_INTO_VALUE(preset->name_len)
-
-                        PARSE_BYTES_INTO_VALUE(preset->name, preset->name_len)
-
-                    PARSE_FOR_EACH_END
-
-                    break;
-
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_EBB:
-                    PARSE_BYTE_INTO_PACKET(ebb.min_level)
-                    PARSE_BYTE_INTO_PACKET(ebb.max_level)
-
-                    break;
-            }
-
-            break;
-
-#undef PACKET_FIELD
-
-        case MDR_PACKET_EQEBB_GET_PARAM:
-#define PACKET_FIELD eqebb_get_param
-
-            PARSE_ENUM_INTO_PACKET(inquired_type)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_INQUIRED_TYPE_EBB)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE)
-            PARSE_ENUM_END
-
-            break;
-
-#undef PACKET_FIELD
-
-        case MDR_PACKET_EQEBB_RET_PARAM:
-        case MDR_PACKET_EQEBB_SET_PARAM:
-        case MDR_PACKET_EQEBB_NTFY_PARAM:
-#define PACKET_FIELD eqebb_ret_param
-
-            PARSE_ENUM_INTO_PACKET(inquired_type)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_INQUIRED_TYPE_EBB)
-                PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE)
-            PARSE_ENUM_END
-
-            switch (FIELD(inquired_type))
-            {
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ:
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE:
-                    PARSE_ENUM_INTO_PACKET(eq.preset_id)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_OFF)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_ROCK)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_POP)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_JAZZ)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_DANCE)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_EDM)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_R_AND_B_HIP_HOP)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_ACOUSTIC)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO8)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO9)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO10)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO11)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO12)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO13)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO14)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO15)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_BRIGHT)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_EXCITED)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_MELLOW)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RELAXED)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_VOCAL)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_TREBLE)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_BASS)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_SPEECH)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO24)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO25)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO26)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO27)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO28)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO29)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO30)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO31)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_CUSTOM)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING1)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING2)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING3)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING4)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING5)
-                        PARSE_ENUM_FIELD(MDR_PACKET_EQEBB_EQ_PRESET_ID_UNSPECIFIED)
-                    PARSE_ENUM_END
-
-                    PARSE_BYTE_INTO_PACKET(eq.num_levels)
-
-                    PARSE_BYTES_INTO_PACKET(eq.levels, FIELD(eq.num_levels))
-
-                    break;
-
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_EBB:
-                    PARSE_BYTE_INTO_PACKET(ebb.level)
-
-                    break;
-            }
-
-            break;
-
-#undef PACKET_FIELD
-
-        default:
-            INVALID_FRAME
-    }
-
-    return packet;
-}
-
-static mdr_frame_t* mdr_packet_eqebb_to_frame(mdr_packet_t* packet)
-{
-    WRITE_INIT(packet)
-    int length;
-
-    switch (packet->type)
-    {
-        case MDR_PACKET_EQEBB_GET_CAPABILITY:
-#define PACKET_FIELD eqebb_get_capability
-
-            WRITE_START(2)
-            WRITE_FIELD(inquired_type)
-            WRITE_FIELD(display_language)
-
-            break;
-
-#undef PACKET_FIELD
-
-        case MDR_PACKET_EQEBB_RET_CAPABILITY:
-#define PACKET_FIELD eqebb_ret_capability
-
-            switch (FIELD(inquired_type))
-            {
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ:
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE:
-                    length = 4;
-
-                    WRITE_FOR_EACH_IN_PACKET(
-                            eq.num_presets,
-                            eq.presets,
-                            mdr_packet_eqebb_capability_eq_preset_name_t,
-                            preset)
-
-                        length += 2 + preset->name_len;
-
-                    WRITE_FOR_EACH_END
-
-                    WRITE_START(length)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(eq.band_count)
-                    WRITE_FIELD(eq.level_steps)
-                    WRITE_FIELD(eq.num_presets)
-
-                    WRITE_FOR_EACH_IN_PACKET(
-                            eq.num_presets,
-                            eq.presets,
-                            mdr_packet_eqebb_capability_eq_preset_name_t,
-                            preset)
-
-                        WRITE_BYTE(preset->preset_id)
-                        WRITE_BYTE(preset->name_len)
-                        WRITE_BYTES(preset->name, preset->name_len)
-
-                    WRITE_FOR_EACH_END
-
-                    break;
-
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_EBB:
-                    WRITE_START(3)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(ebb.min_level)
-                    WRITE_FIELD(ebb.max_level)
-
-                    break;
-            }
-
-            break;
-
-#undef PACKET_FIELD
-
-        case MDR_PACKET_EQEBB_GET_PARAM:
-#define PACKET_FIELD eqebb_get_param
-
-            WRITE_START(1)
-            WRITE_FIELD(inquired_type)
-
-            break;
-
-#undef PACKET_FIELD
-
-        case MDR_PACKET_EQEBB_RET_PARAM:
-        case MDR_PACKET_EQEBB_SET_PARAM:
-        case MDR_PACKET_EQEBB_NTFY_PARAM:
-#define PACKET_FIELD eqebb_ret_param
-
-            switch (FIELD(inquired_type))
-            {
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ:
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE:
-                    WRITE_START(3 + FIELD(eq.num_levels))
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(eq.preset_id)
-                    WRITE_FIELD(eq.num_levels)
-                    WRITE_FIELD_BYTES(eq.levels, FIELD(eq.num_levels))
-
-                    break;
-
-                case MDR_PACKET_EQEBB_INQUIRED_TYPE_EBB:
-                    WRITE_START(2)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(ebb.level)
-
-                    break;
-            }
-
-            break;
-
-#undef PACKET_FIELD
-
-        default:
-            errno = MDR_E_INVALID_PACKET;
-            return NULL;
-    }
-
-    return frame;
-}
-
+#include "./schema.h"
+
+#define EQEBB_INQUIRED_TYPES(V) \
+    V(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ) \
+    V(MDR_PACKET_EQEBB_INQUIRED_TYPE_EBB) \
+    V(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE)
+
+#define EQEBB_DISPLAY_LANGUAGES(V) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_UNDEFINED_LANGUAGE) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_ENGLISH) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_FRENCH) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_GERMAN) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_SPANISH) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_ITALIAN) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_PORTUGUESE) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_DUTCH) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_SWEDISH) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_FINNISH) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_RUSSIAN) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_JAPANESE) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_SIMPLIFIED_CHINESE) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_BRAZILIAN_PORTUGUESE) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_TRADITIONAL_CHINESE) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_KOREAN) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_TURKISH) \
+    V(MDR_PACKET_EQEBB_DISPLAY_LANGUAGE_CHINESE)
+
+#define EQEBB_EQ_PRESET_IDS(V) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_OFF) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_ROCK) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_POP) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_JAZZ) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_DANCE) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_EDM) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_R_AND_B_HIP_HOP) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_ACOUSTIC) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO8) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO9) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO10) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO11) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO12) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO13) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO14) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO15) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_BRIGHT) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_EXCITED) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_MELLOW) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RELAXED) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_VOCAL) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_TREBLE) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_BASS) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_SPEECH) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO24) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO25) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO26) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO27) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO28) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO29) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO30) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_RESERVED_FOR_FUTURE_NO31) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_CUSTOM) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING1) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING2) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING3) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING4) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_USER_SETTING5) \
+    V(MDR_PACKET_EQEBB_EQ_PRESET_ID_UNSPECIFIED)
+
+#define EQEBB_GET_CAPABILITY(OP, p) \
+    OP##_ENUM(p.inquired_type, EQEBB_INQUIRED_TYPES) \
+    OP##_ENUM(p.display_language, EQEBB_DISPLAY_LANGUAGES)
+
+#define EQEBB_RET_CAPABILITY(OP, p) \
+    OP##_ENUM(p.inquired_type, EQEBB_INQUIRED_TYPES) \
+    OP##_SWITCH(p.inquired_type) \
+        OP##_CASE(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ) \
+        OP##_ALSO(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE) \
+            OP##_BYTE(p.eq.band_count) \
+            OP##_BYTE(p.eq.level_steps) \
+            OP##_ARRAY(p.eq.num_presets, \
+                       p.eq.presets, \
+                       mdr_packet_eqebb_capability_eq_preset_name_t, \
+                       preset) \
+                OP##_ENUM(preset->preset_id, EQEBB_EQ_PRESET_IDS) \
+                OP##_BYTES(preset->name_len, preset->name) \
+            OP##_ARRAY_END \
+        OP##_CASE(MDR_PACKET_EQEBB_INQUIRED_TYPE_EBB) \
+            OP##_BYTE(p.ebb.min_level) \
+            OP##_BYTE(p.ebb.max_level) \
+    OP##_SWITCH_END
+
+#define EQEBB_GET_PARAM(OP, p) \
+    OP##_ENUM(p.inquired_type, EQEBB_INQUIRED_TYPES)
+
+#define EQEBB_PARAM(OP, p) \
+    OP##_ENUM(p.inquired_type, EQEBB_INQUIRED_TYPES) \
+    OP##_SWITCH(p.inquired_type) \
+        OP##_CASE(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ) \
+        OP##_ALSO(MDR_PACKET_EQEBB_INQUIRED_TYPE_PRESET_EQ_NONCUSTOMIZABLE) \
+            OP##_ENUM(p.eq.preset_id, EQEBB_EQ_PRESET_IDS) \
+            OP##_BYTES(p.eq.num_levels, p.eq.levels) \
+        OP##_CASE(MDR_PACKET_EQEBB_INQUIRED_TYPE_EBB) \
+            OP##_BYTE(p.ebb.level) \
+    OP##_SWITCH_END
+
+#define EQEBB_PACKETS(P) \
+    P(MDR_PACKET_EQEBB_GET_CAPABILITY, \
+      eqebb_get_capability, \
+      EQEBB_GET_CAPABILITY) \
+    P(MDR_PACKET_EQEBB_RET_CAPABILITY, \
+      eqebb_ret_capability, \
+      EQEBB_RET_CAPABILITY) \
+    P(MDR_PACKET_EQEBB_GET_PARAM, eqebb_get_param, EQEBB_GET_PARAM) \
+    P(MDR_PACKET_EQEBB_RET_PARAM, eqebb_ret_param, EQEBB_PARAM) \
+    P(MDR_PACKET_EQEBB_SET_PARAM, eqebb_ret_param, EQEBB_PARAM) \
+    P(MDR_PACKET_EQEBB_NTFY_PARAM, eqebb_ret_param, EQEBB_PARAM)
+
+SCHEMA_CODEC(eqebb, EQEBB_PACKETS)
@@ -0,0 +1,351 @@
+/*
+ * libmdr - MDR protocol library
+ *
+ *  Copyright (C) 2021 Andreas Olofsson
+ *
+ *
+ * This file is part of libmdr.
+ *
+ * libmdr is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libmdr is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libmdr. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __MDR_PACKET_SCHEMA_H__
+#define __MDR_PACKET_SCHEMA_H__
+
+#include "./util.h"
+#include "./wire.h"
+
+#include <mdr/errors.h>
+
+/*
+ * Packets are described once as a schema, a macro taking an operation
+ * `OP` and the packet data `p` it applies to:
+ *
+ *   #define EXAMPLE_PARAM(OP, p) \
+ *       OP##_ENUM(p.inquired_type, EXAMPLE_INQUIRED_TYPES) \
+ *       OP##_SWITCH(p.inquired_type) \
+ *           OP##_CASE(EXAMPLE_INQUIRED_TYPE_LEVEL) \
+ *               OP##_BYTE(p.level) \
+ *           OP##_CASE(EXAMPLE_INQUIRED_TYPE_NAME) \
+ *               OP##_STRING(p.name.len, p.name.data, 128) \
+ *       OP##_SWITCH_END
+ *
+ * Expanding a schema with SCHEMA_PARSE, SCHEMA_SIZE, SCHEMA_WRITE or
+ * SCHEMA_WIRE generates straight-line code decoding it, computing its
+ * encoded size, encoding it into a frame or encoding it straight into
+ * escaped wire bytes. `SCHEMA_CODEC` generates the codec of a whole family.
+ *
+ * The fields are:
+ *
+ *  - OP##_BYTE(value), a single byte.
+ *  - OP##_ENUM(value, VALUES), a single byte which must be one of the
+ *    values listed by the X-macro `VALUES(V)`.
+ *  - OP##_BYTES(len, data), a length byte followed by that many bytes.
+ *  - OP##_STRING(len, data, max), same as OP##_BYTES except the length
+ *    is clamped to `max` when decoding.
+ *  - OP##_ARRAY(count, array, type, name) ... OP##_ARRAY_END,
+ *    a count byte followed by that many elements, each described by the
+ *    fields in between applied to `*name`.
+ *  - OP##_SWITCH(value), OP##_CASE(x), OP##_ALSO(x), OP##_SWITCH_END,
+ *    the fields following OP##_CASE(x) and any OP##_ALSO(y) directly
+ *    after it are only present if `value` is `x` (or `y`).
+ *  - OP##_CUSTOM(value, codec), a field with a hand-written codec:
+ *
+ *      void* codec_parse(type* value, uint8_t* payload,
+ *                        uint32_t payload_length, uint32_t* offset,
+ *                        parse_arena_t* arena);
+ *      size_t codec_size(type* value);
+ *      void codec_write(type* value, uint8_t* payload, uint32_t* offset);
+ *      void codec_wire(type* value, wire_t* wire);
+ *
+ *    `codec_parse` returns `value`, or NULL with errno set on error.
+ */
+
+/*
+ * Evaluates to 1, fails to compile unless `value` is a single byte.
+ */
+#define SCHEMA_BYTE_SIZE(value) \
+    sizeof(char[sizeof(value) == 1 ? 1 : -1])
+
+// Decoding, see PARSE_INIT.
+
+#define SCHEMA_PARSE_BYTE(value) \
+    PARSE_BYTE_INTO_VALUE(value)
+
+#define SCHEMA_PARSE_ENUM(value, values) \
+    PARSE_ENUM_INTO_VALUE(value) \
+        values(PARSE_ENUM_FIELD) \
+    PARSE_ENUM_END
+
+#define SCHEMA_PARSE_BYTES(len, data) \
+    PARSE_BYTE_INTO_VALUE(len) \
+    PARSE_BYTES_INTO_VALUE(data, len)
+
+#define SCHEMA_PARSE_STRING(len, data, max) \
+    PARSE_BYTE_INTO_VALUE(len) \
+    if ((len) > (max)) \
+    { \
+        (len) = (max); \
+    } \
+    PARSE_BYTES_INTO_VALUE(data, len)
+
+#define SCHEMA_PARSE_ARRAY(count, array, type, name) \
+    PARSE_BYTE_INTO_VALUE(count) \
+    PARSE_FOR_EACH_INTO_VALUE(count, array, type, name)
+
+#define SCHEMA_PARSE_ARRAY_END \
+    PARSE_FOR_EACH_END
+
+#define SCHEMA_PARSE_CUSTOM(value, codec) \
+    if (codec##_parse(&(value), payload, payload_length, &offset, arena) \
+            == NULL) \
+    { \
+        return NULL; \
+    }
+
+#define SCHEMA_PARSE_SWITCH(value) \
+    switch (value) \
+    { \
+        default: \
+            INVALID_FRAME
+
+#define SCHEMA_PARSE_CASE(value) \
+        break; \
+        case value:
+
+#define SCHEMA_PARSE_ALSO(value) \
+        case value:
+
+#define SCHEMA_PARSE_SWITCH_END \
+        break; \
+    }
+
+// Encoded size, added to `length`.
+
+#define SCHEMA_SIZE_BYTE(value) \
+    length += SCHEMA_BYTE_SIZE(value);
+
+#define SCHEMA_SIZE_ENUM(value, values) \
+    length += 1;
+
+#define SCHEMA_SIZE_BYTES(len, data) \
+    length += SCHEMA_BYTE_SIZE(len) + SCHEMA_BYTE_SIZE(*(data)) * (len);
+
+#define SCHEMA_SIZE_STRING(len, data, max) \
+    SCHEMA_SIZE_BYTES(len, data)
+
+#define SCHEMA_SIZE_ARRAY(count, array, type, name) \
+    length += SCHEMA_BYTE_SIZE(count); \
+    for (type* name = (array); name != &(array)[count]; name++) \
+    {
+
+#define SCHEMA_SIZE_ARRAY_END \
+    }
+
+#define SCHEMA_SIZE_CUSTOM(value, codec) \
+    length += codec##_size(&(value));
+
+#define SCHEMA_SIZE_SWITCH(value) \
+    switch (value) \
+    { \
+        default: \
+            errno = MDR_E_INVALID_PACKET; \
+            return 0;
+
+#define SCHEMA_SIZE_CASE(value) \
+        break; \
+        case value:
+
+#define SCHEMA_SIZE_ALSO(value) \
+        case value:
+
+#define SCHEMA_SIZE_SWITCH_END \
+        break; \
+    }
+
+// Encoding, see WRITE_START.
+
+#define SCHEMA_WRITE_BYTE(value) \
+    WRITE_BYTE(value)
+
+#define SCHEMA_WRITE_ENUM(value, values) \
+    WRITE_BYTE(value)
+
+#define SCHEMA_WRITE_BYTES(len, data) \
+    WRITE_BYTE(len) \
+    WRITE_BYTES(data, len)
+
+#define SCHEMA_WRITE_STRING(len, data, max) \
+    SCHEMA_WRITE_BYTES(len, data)
+
+#define SCHEMA_WRITE_ARRAY(count, array, type, name) \
+    WRITE_BYTE(count) \
+    WRITE_FOR_EACH_IN_VALUE(count, array, type, name)
+
+#define SCHEMA_WRITE_ARRAY_END \
+    WRITE_FOR_EACH_END
+
+#define SCHEMA_WRITE_CUSTOM(value, codec) \
+    codec##_write(&(value), payload, &offset);
+
+#define SCHEMA_WRITE_SWITCH(value) \
+    switch (value) \
+    { \
+        default:
+
+#define SCHEMA_WRITE_CASE(value) \
+        break; \
+        case value:
+
+#define SCHEMA_WRITE_ALSO(value) \
+        case value:
+
+#define SCHEMA_WRITE_SWITCH_END \
+        break; \
+    }
+
+// Encoding into escaped wire bytes, see wire_t.
+
+#define SCHEMA_WIRE_BYTE(value) \
+    wire_put(wire, value);
+
+#define SCHEMA_WIRE_ENUM(value, values) \
+    wire_put(wire, value);
+
+#define SCHEMA_WIRE_BYTES(len, data) \
+    wire_put(wire, len); \
+    wire_put_bytes(wire, data, len);
+
+#define SCHEMA_WIRE_STRING(len, data, max) \
+    SCHEMA_WIRE_BYTES(len, data)
+
+#define SCHEMA_WIRE_ARRAY(count, array, type, name) \
+    wire_put(wire, count); \
+    WRITE_FOR_EACH_IN_VALUE(count, array, type, name)
+
+#define SCHEMA_WIRE_ARRAY_END \
+    WRITE_FOR_EACH_END
+
+#define SCHEMA_WIRE_CUSTOM(value, codec) \
+    codec##_wire(&(value), wire);
+
+#define SCHEMA_WIRE_SWITCH(value) \
+    SCHEMA_WRITE_SWITCH(value)
+
+#define SCHEMA_WIRE_CASE(value) \
+    SCHEMA_WRITE_CASE(value)
+
+#define SCHEMA_WIRE_ALSO(value) \
+    SCHEMA_WRITE_ALSO(value)
+
+#define SCHEMA_WIRE_SWITCH_END \
+    SCHEMA_WRITE_SWITCH_END
+
+// Families
+
+#define SCHEMA_PARSE_PACKET(type, field, schema) \
+    case type: \
+        schema(SCHEMA_PARSE, packet->data.field) \
+        break;
+
+#define SCHEMA_SIZE_PACKET(type, field, schema) \
+    case type: \
+        schema(SCHEMA_SIZE, packet->data.field) \
+        break;
+
+#define SCHEMA_WRITE_PACKET(type, field, schema) \
+    case type: \
+        schema(SCHEMA_WRITE, packet->data.field) \
+        break;
+
+#define SCHEMA_WIRE_PACKET(type, field, schema) \
+    case type: \
+        schema(SCHEMA_WIRE, packet->data.field) \
+        break;
+
+/*
+ * Generate the codec of a packet family from the X-macro `PACKETS(P)`,
+ * listing every packet type of the family as
+ * `P(type, field of mdr_packet_data_t, schema)`.
+ *
+ * Generates:
+ *
+ *  - mdr_packet_<family>_from_frame, decoding a packet.
+ *  - mdr_packet_<family>_encoded_size, the exact payload length of a
+ *    packet, 0 with errno set if it can't be encoded.
+ *  - mdr_packet_<family>_to_frame, encoding a packet.
+ *  - mdr_packet_<family>_to_wire, writing the escaped payload of a packet
+ *    which must have a valid encoded size.
+ */
+#define SCHEMA_CODEC(family, PACKETS) \
+    static mdr_packet_t* mdr_packet_##family##_from_frame( \
+            mdr_frame_t* frame, \
+            parse_arena_t* arena) \
+    { \
+        PARSE_INIT(frame) \
+        switch (packet->type) \
+        { \
+            PACKETS(SCHEMA_PARSE_PACKET) \
+            default: \
+                INVALID_FRAME \
+        } \
+        return packet; \
+    } \
+    \
+    static size_t mdr_packet_##family##_encoded_size(mdr_packet_t* packet) \
+    { \
+        size_t length = 1; \
+        switch (packet->type) \
+        { \
+            PACKETS(SCHEMA_SIZE_PACKET) \
+            default: \
+                errno = MDR_E_INVALID_PACKET; \
+                return 0; \
+        } \
+        return length; \
+    } \
+    \
+    static mdr_frame_t* mdr_packet_##family##_to_frame( \
+            mdr_packet_t* packet, \
+            mdr_frame_pool_t* pool) \
+    { \
+        size_t length = mdr_packet_##family##_encoded_size(packet); \
+        if (length == 0) \
+        { \
+            return NULL; \
+        } \
+        WRITE_INIT(packet) \
+        WRITE_START(length - 1) \
+        switch (packet->type) \
+        { \
+            PACKETS(SCHEMA_WRITE_PACKET) \
+            default: \
+                break; \
+        } \
+        return frame; \
+    } \
+    \
+    static void mdr_packet_##family##_to_wire(mdr_packet_t* packet, \
+                                              wire_t* wire) \
+    { \
+        wire_put(wire, packet->type); \
+        switch (packet->type) \
+        { \
+            PACKETS(SCHEMA_WIRE_PACKET) \
+            default: \
+                break; \
+        } \
+    }
+
+#endif /* __MDR_PACKET_SCHEMA_H__ */
@@ -22,710 +22,374 @@
 
 #include <errno.h>
 
-#include "./util.h"
+#include "./schema.h"
+
+#define SYSTEM_INQUIRED_TYPES(V) \
+    V(MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR) \
+    V(MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE) \
+    V(MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING) \
+    V(MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF) \
+    V(MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE) \
+    V(MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS)
+
+#define SYSTEM_VIBRATOR_SETTING_TYPES(V) \
+    V(MDR_PACKET_SYSTEM_VIBRATOR_SETTING_TYPE_ON_OFF)
+
+#define SYSTEM_VIBRATOR_SETTING_VALUES(V) \
+    V(MDR_PACKET_SYSTEM_VIBRATOR_SETTING_VALUE_OFF) \
+    V(MDR_PACKET_SYSTEM_VIBRATOR_SETTING_VALUE_ON)
+
+#define SYSTEM_POWER_SAVING_MODE_SETTING_TYPES(V) \
+    V(MDR_PACKET_SYSTEM_POWER_SAVING_MODE_SETTING_TYPE_ON_OFF)
+
+#define SYSTEM_POWER_SAVING_MODE_SETTING_VALUES(V) \
+    V(MDR_PACKET_SYSTEM_POWER_SAVING_MODE_SETTING_VALUE_OFF) \
+    V(MDR_PACKET_SYSTEM_POWER_SAVING_MODE_SETTING_VALUE_ON)
+
+#define SYSTEM_CONTROL_BY_WEARING_SETTING_TYPES(V) \
+    V(MDR_PACKET_SYSTEM_CONTROL_BY_WEARING_SETTING_TYPE_ON_OFF)
+
+#define SYSTEM_CONTROL_BY_WEARING_SETTING_VALUES(V) \
+    V(MDR_PACKET_SYSTEM_CONTROL_BY_WEARING_SETTING_VALUE_OFF) \
+    V(MDR_PACKET_SYSTEM_CONTROL_BY_WEARING_SETTING_VALUE_ON)
+
+#define SYSTEM_AUTO_POWER_OFF_ELEMENT_IDS(V) \
+    V(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_5_MIN) \
+    V(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_30_MIN) \
+    V(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_60_MIN) \
+    V(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_180_MIN) \
+    V(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_WHEN_REMOVED_FROM_EARS) \
+    V(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_DISABLE)
+
+#define SYSTEM_AUTO_POWER_OFF_PARAMETER_TYPES(V) \
+    V(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_PARAMETER_TYPE_ACTIVE_AND_SELECT_TIME_ID)
+
+#define SYSTEM_SMART_TALKING_MODE_SETTING_TYPES(V) \
+    V(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_SETTING_TYPE_ON_OFF)
+
+#define SYSTEM_SMART_TALKING_MODE_SETTING_VALUES(V) \
+    V(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_SETTING_VALUE_OFF) \
+    V(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_SETTING_VALUE_ON)
+
+#define SYSTEM_SMART_TALKING_MODE_PREVIEW_TYPES(V) \
+    V(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_PREVIEW_TYPE_NOT_SUPPORT) \
+    V(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_PREVIEW_TYPE_SUPPORT)
+
+#define SYSTEM_SMART_TALKING_MODE_DETAIL_SETTING_TYPES(V) \
+    V(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_DETAIL_SETTING_TYPE_TYPE_1)
+
+#define SYSTEM_SMART_TALKING_MODE_DETECTION_SENSITIVITY_TYPES(V) \
+    V(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_DETECTION_SENSITIVITY_TYPE_AUTO_HIGH_LOW)
+
+#define SYSTEM_SMART_TALKING_MODE_VOICE_FOCUS_TYPES(V) \
+    V(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_VOICE_FOCUS_TYPE_ON_OFF)
+
+#define SYSTEM_SMART_TALKING_MODE_MODE_OUT_TIME_TYPES(V) \
+    V(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_MODE_OUT_TIME_TYPE_TYPE_1)
+
+#define SYSTEM_ASSIGNABLE_SETTINGS_KEYS(V) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_KEY_LEFT_SIDE_KEY) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_KEY_RIGHT_SIDE_KEY) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_KEY_CUSTOM_KEY) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_KEY_C_KEY)
+
+#define SYSTEM_ASSIGNABLE_SETTINGS_KEY_TYPES(V) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_KEYS_TYPE_TOUCH_SENSOR) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_KEYS_TYPE_BUTTON)
+
+#define SYSTEM_ASSIGNABLE_SETTINGS_PRESETS(V) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_AMBIENT_SOUND_CONTROL) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_VOLUME_CONTROL) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_PLAYBACK_CONTROL) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_VOICE_RECOGNITION) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_GOOGLE_ASSISTANT) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_AMAZON_ALEXA) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_TENCENT_XIAOWEI) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_NO_FUNCTION)
+
+#define SYSTEM_ASSIGNABLE_SETTINGS_ACTIONS(V) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_SINGLE_TAP) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_DOUBLE_TAP) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_TRIPLE_TAP) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_SINGLE_TAP_AND_HOLD) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_DOUBLE_TAP_AND_HOLD) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_LONG_PRESS_THEN_ACTIVATE) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_LONG_PRESS_DURING_ACTIVATION)
+
+#define SYSTEM_ASSIGNABLE_SETTINGS_FUNCTIONS(V) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_NO_FUNCTION) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_NC_ASM_OFF) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_NC_OPTIMIZER) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_QUICK_ATTENTION) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_VOLUME_UP) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_VOLUME_DOWN) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_PLAY_PAUSE) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_NEXT_TRACK) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_PREVIOUS_TRACK) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_VOICE_RECOGNITION) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_GET_YOUR_NOTIFICATION) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_TALK_TO_GA) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_STOP_GA) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_VOICE_INPUT_CANCEL_AA) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_TALK_TO_TENCENT_XIAOWEI) \
+    V(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_CANCEL_VOICE_RECOGNITION)
 
-#include <mdr/errors.h>
+/*
+ * The encoding of the assignable settings capability tree,
+ * see `assignable_settings_capability_parse` for how it's decoded.
+ */
+#define SYSTEM_ASSIGNABLE_SETTINGS_CAPABILITY_KEYS(OP, p) \
+    OP##_ARRAY(p.num_capability_keys, \
+               p.capability_keys, \
+               mdr_packet_system_assignable_settings_capability_key_t, \
+               capability_key) \
+        OP##_ENUM(capability_key->key, \
+                  SYSTEM_ASSIGNABLE_SETTINGS_KEYS) \
+        OP##_ENUM(capability_key->key_type, \
+                  SYSTEM_ASSIGNABLE_SETTINGS_KEY_TYPES) \
+        OP##_ENUM(capability_key->default_preset, \
+                  SYSTEM_ASSIGNABLE_SETTINGS_PRESETS) \
+        OP##_ARRAY(capability_key->num_capability_presets, \
+                   capability_key->capability_presets, \
+                   mdr_packet_system_assignable_settings_capability_preset_t, \
+                   capability_preset) \
+            OP##_ENUM(capability_preset->preset, \
+                      SYSTEM_ASSIGNABLE_SETTINGS_PRESETS) \
+            OP##_ARRAY(capability_preset->num_capability_actions, \
+                       capability_preset->capability_actions, \
+                       mdr_packet_system_assignable_settings_capability_action_t, \
+                       capability_action) \
+                OP##_ENUM(capability_action->action, \
+                          SYSTEM_ASSIGNABLE_SETTINGS_ACTIONS) \
+                OP##_ENUM(capability_action->function, \
+                          SYSTEM_ASSIGNABLE_SETTINGS_FUNCTIONS) \
+            OP##_ARRAY_END \
+        OP##_ARRAY_END \
+    OP##_ARRAY_END
+
+typedef mdr_packet_system_assignable_settings_capability_key_t
+        capability_key_t;
+typedef mdr_packet_system_assignable_settings_capability_preset_t
+        capability_preset_t;
+typedef mdr_packet_system_assignable_settings_capability_action_t
+        capability_action_t;
 
-static void mdr_packet_system_free(mdr_packet_t* packet)
+/*
+ * The capability tree of the assignable settings is decoded one level at
+ * a time, the presets of every key are stored in a single array and so
+ * are the actions of every preset. The first pass only counts them.
+ */
+static void* assignable_settings_capability_parse(
+        mdr_packet_system_capability_assignable_settings_t* value,
+        uint8_t* payload,
+        uint32_t payload_length,
+        uint32_t* offset_ptr,
+        parse_arena_t* arena)
 {
-    switch (packet->type)
-    {
-        case MDR_PACKET_SYSTEM_GET_CAPABILITY:
-            break;
-
-        case MDR_PACKET_SYSTEM_RET_CAPABILITY:
-#define PACKET_FIELD system_ret_capability
-
-            switch (packet->data.system_ret_capability.inquired_type)
-            {
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING:
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF:
-                    FREE_FIELD(auto_power_off.element_ids);
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE:
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS:
-                    FREE_FOR_EACH_IN_PACKET(
-                            assignable_settings.num_capability_keys,
-                            assignable_settings.capability_keys,
-                            mdr_packet_system_assignable_settings_capability_key_t,
-                            capability_keys)
-
-                        FREE_FOR_EACH_IN_VALUE(
-                                capability_keys->num_capability_presets,
-                                capability_keys->capability_presets,
-                                mdr_packet_system_assignable_settings_capability_preset_t,
-                                capability_presets)
-
-                            free(capability_presets->capability_actions);
-
-                        FREE_FOR_EACH_END
-
-                        free(capability_keys->capability_presets);
-
-                    FREE_FOR_EACH_END
-
-                    FREE_FIELD(assignable_settings.capability_keys)
-
-                    break;
-            }
-            break;
-
-#undef PACKET_FIELD
-
-        case MDR_PACKET_SYSTEM_GET_PARAM:
-            break;
-
-        case MDR_PACKET_SYSTEM_RET_PARAM:
-#define PACKET_FIELD system_ret_param
-
-            switch (packet->data.system_ret_param.inquired_type)
-            {
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE:
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS:
-                    FREE_FIELD(assignable_settings.presets)
-
-                    break;
-            }
-
-#undef PACKET_FIELD
-            break;
+    uint32_t offset = *offset_ptr;
+    size_t num_presets = 0;
+    size_t num_actions = 0;
 
-        case MDR_PACKET_SYSTEM_SET_PARAM:
-#define PACKET_FIELD system_set_param
-
-            switch (packet->data.system_set_param.inquired_type)
-            {
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE:
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS:
-                    FREE_FIELD(assignable_settings.presets)
+    uint8_t num_keys;
+    PARSE_BYTE_INTO_VALUE(num_keys)
+    for (int key = 0; key < num_keys; key++)
+    {
+        // Key, key type and default preset.
+        offset += 3;
 
-                    break;
-            }
+        uint8_t key_presets;
+        PARSE_BYTE_INTO_VALUE(key_presets)
+        num_presets += key_presets;
 
-#undef PACKET_FIELD
-            break;
+        for (int preset = 0; preset < key_presets; preset++)
+        {
+            offset += 1;
 
-        case MDR_PACKET_SYSTEM_NTFY_PARAM:
-#define PACKET_FIELD system_ntfy_param
+            uint8_t preset_actions;
+            PARSE_BYTE_INTO_VALUE(preset_actions)
+            num_actions += preset_actions;
 
-            switch (packet->data.system_ntfy_param.inquired_type)
+            // Action and function of each action.
+            offset += 2 * preset_actions;
+            if (offset > payload_length)
             {
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF:
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE:
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS:
-                    FREE_FIELD(assignable_settings.presets)
-
-                    break;
+                INVALID_FRAME;
             }
-
-#undef PACKET_FIELD
-            break;
-
-        default:
-            break;
+        }
     }
-}
 
-static mdr_packet_t* mdr_packet_system_from_frame(mdr_frame_t* frame)
-{
-    PARSE_INIT(frame)
+    capability_key_t* keys;
+    capability_preset_t* presets;
+    capability_action_t* actions;
+    PARSE_ALLOC_VALUE(keys, sizeof(capability_key_t) * num_keys)
+    PARSE_ALLOC_VALUE(presets, sizeof(capability_preset_t) * num_presets)
+    PARSE_ALLOC_VALUE(actions, sizeof(capability_action_t) * num_actions)
 
-    switch (mdr_frame_payload(frame)[0])
-    {
-        case MDR_PACKET_SYSTEM_GET_CAPABILITY:
-#define PACKET_FIELD system_get_capability
-
-            PARSE_ENUM_INTO_PACKET(inquired_type)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS)
-            PARSE_ENUM_END
-
-#undef PACKET_FIELD
-            break;
-
-        case MDR_PACKET_SYSTEM_RET_CAPABILITY:
-#define PACKET_FIELD system_ret_capability
-
-            PARSE_ENUM_INTO_PACKET(inquired_type)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS)
-            PARSE_ENUM_END
-
-            switch (packet->data.system_ret_capability.inquired_type)
-            {
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR:
-                    PARSE_ENUM_INTO_PACKET(vibrator.setting_type)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_VIBRATOR_SETTING_TYPE_ON_OFF)
-                    PARSE_ENUM_END
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE:
-                    PARSE_ENUM_INTO_PACKET(power_saving_mode.setting_type)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_POWER_SAVING_MODE_SETTING_TYPE_ON_OFF)
-                    PARSE_ENUM_END
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING:
-                    PARSE_ENUM_INTO_PACKET(control_by_wearing.setting_type)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_CONTROL_BY_WEARING_SETTING_TYPE_ON_OFF)
-                    PARSE_ENUM_END
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF:
-                    PARSE_BYTE_INTO_PACKET(auto_power_off.element_id_count)
-
-                    PARSE_FOR_EACH_IN_PACKET(auto_power_off.element_id_count,
-                                             auto_power_off.element_ids,
-                                             mdr_packet_system_auto_power_off_element_id_t,
-                                             element_id)
-
-                        PARSE_ENUM_INTO_VALUE(*element_id)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_5_MIN)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_30_MIN)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_60_MIN)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_180_MIN)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_WHEN_REMOVED_FROM_EARS)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_DISABLE)
-                        PARSE_ENUM_END
-
-                    PARSE_FOR_EACH_END
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE:
-                    PARSE_ENUM_INTO_PACKET(smart_talking_mode.setting_type)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_SETTING_TYPE_ON_OFF)
-                    PARSE_ENUM_END
-
-                    PARSE_ENUM_INTO_PACKET(smart_talking_mode.preview_type)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_PREVIEW_TYPE_NOT_SUPPORT)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_PREVIEW_TYPE_SUPPORT)
-                    PARSE_ENUM_END
-
-                    PARSE_ENUM_INTO_PACKET(smart_talking_mode.detail_setting)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_DETAIL_SETTING_TYPE_TYPE_1)
-                    PARSE_ENUM_END
-
-                    PARSE_ENUM_INTO_PACKET(smart_talking_mode.detection_sensitivity_type)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_DETECTION_SENSITIVITY_TYPE_AUTO_HIGH_LOW)
-                    PARSE_ENUM_END
-
-                    PARSE_ENUM_INTO_PACKET(smart_talking_mode.voice_focus_type)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_VOICE_FOCUS_TYPE_ON_OFF)
-                    PARSE_ENUM_END
-
-                    PARSE_ENUM_INTO_PACKET(smart_talking_mode.mode_out_time_type_t)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_MODE_OUT_TIME_TYPE_TYPE_1)
-                    PARSE_ENUM_END
-
-                    PARSE_BYTE_INTO_PACKET(smart_talking_mode.timeouts[0])
-                    PARSE_BYTE_INTO_PACKET(smart_talking_mode.timeouts[1])
-                    PARSE_BYTE_INTO_PACKET(smart_talking_mode.timeouts[2])
-                    PARSE_BYTE_INTO_PACKET(smart_talking_mode.timeouts[3])
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS:
-                    PARSE_BYTE_INTO_PACKET(assignable_settings.num_capability_keys)
-
-                    PARSE_FOR_EACH_IN_PACKET(
-                            assignable_settings.num_capability_keys,
-                            assignable_settings.capability_keys,
-                            mdr_packet_system_assignable_settings_capability_key_t,
-                            capability_key)
-
-                        PARSE_ENUM_INTO_VALUE(capability_key->key)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_KEY_LEFT_SIDE_KEY)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_KEY_RIGHT_SIDE_KEY)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_KEY_CUSTOM_KEY)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_KEY_C_KEY)
-                        PARSE_ENUM_END
-
-                        PARSE_ENUM_INTO_VALUE(capability_key->key_type)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_KEYS_TYPE_TOUCH_SENSOR)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_KEYS_TYPE_BUTTON)
-                        PARSE_ENUM_END
-
-                        PARSE_ENUM_INTO_VALUE(capability_key->default_preset)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_AMBIENT_SOUND_CONTROL)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_VOLUME_CONTROL)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_PLAYBACK_CONTROL)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_VOICE_RECOGNITION)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_GOOGLE_ASSISTANT)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_AMAZON_ALEXA)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_TENCENT_XIAOWEI)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_NO_FUNCTION)
-                        PARSE_ENUM_END
-
-                        PARSE_BYTE_INTO_VALUE(capability_key->num_capability_presets)
-
-                        PARSE_FOR_EACH_INTO_VALUE(
-                                capability_key->num_capability_presets,
-                                capability_key->capability_presets,
-                                mdr_packet_system_assignable_settings_capability_preset_t,
-                                capability_preset)
-
-                            PARSE_ENUM_INTO_VALUE(capability_preset->preset)
-                                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_AMBIENT_SOUND_CONTROL)
-                                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_VOLUME_CONTROL)
-                                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_PLAYBACK_CONTROL)
-                                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_VOICE_RECOGNITION)
-                                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_GOOGLE_ASSISTANT)
-                                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_AMAZON_ALEXA)
-                                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_TENCENT_XIAOWEI)
-                                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_NO_FUNCTION)
-                            PARSE_ENUM_END
-
-                            PARSE_BYTE_INTO_VALUE(capability_preset->num_capability_actions)
-
-                            PARSE_FOR_EACH_INTO_VALUE(
-                                    capability_preset->num_capability_actions,
-                                    capability_preset->capability_actions,
-                                    mdr_packet_system_assignable_settings_capability_action_t,
-                                    capability_action)
-
-                                PARSE_ENUM_INTO_VALUE(capability_action->action)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_SINGLE_TAP)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_DOUBLE_TAP)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_TRIPLE_TAP)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_SINGLE_TAP_AND_HOLD)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_DOUBLE_TAP_AND_HOLD)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_LONG_PRESS_THEN_ACTIVATE)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_ACTION_LONG_PRESS_DURING_ACTIVATION)
-                                PARSE_ENUM_END
-
-                                PARSE_ENUM_INTO_VALUE(capability_action->function)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_NO_FUNCTION)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_NC_ASM_OFF)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_NC_OPTIMIZER)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_QUICK_ATTENTION)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_VOLUME_UP)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_VOLUME_DOWN)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_PLAY_PAUSE)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_NEXT_TRACK)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_PREVIOUS_TRACK)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_VOICE_RECOGNITION)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_GET_YOUR_NOTIFICATION)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_TALK_TO_GA)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_STOP_GA)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_VOICE_INPUT_CANCEL_AA)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_TALK_TO_TENCENT_XIAOWEI)
-                                    PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_FUNCTION_CANCEL_VOICE_RECOGNITION)
-                                PARSE_ENUM_END
-
-                            PARSE_FOR_EACH_END
-
-                        PARSE_FOR_EACH_END
-
-                    PARSE_FOR_EACH_END
-
-                    break;
-            }
+    offset = *offset_ptr + 1;
+    value->num_capability_keys = num_keys;
+    value->capability_keys = keys;
 
-#undef PACKET_FIELD
-            break;
-
-        case MDR_PACKET_SYSTEM_GET_PARAM:
-#define PACKET_FIELD system_get_param
-
-            PARSE_ENUM_INTO_PACKET(inquired_type)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS)
-            PARSE_ENUM_END
-
-#undef PACKET_FIELD
-            break;
-
-        case MDR_PACKET_SYSTEM_RET_PARAM:
-        case MDR_PACKET_SYSTEM_SET_PARAM:
-        case MDR_PACKET_SYSTEM_NTFY_PARAM:
-#define PACKET_FIELD system_ret_param
-
-            PARSE_ENUM_INTO_PACKET(inquired_type)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE)
-                PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS)
-            PARSE_ENUM_END
-
-            switch (packet->data.system_ret_param.inquired_type)
+    for (capability_key_t* key = keys; key != &keys[num_keys]; key++)
+    {
+        SCHEMA_PARSE_ENUM(key->key, SYSTEM_ASSIGNABLE_SETTINGS_KEYS)
+        SCHEMA_PARSE_ENUM(key->key_type, SYSTEM_ASSIGNABLE_SETTINGS_KEY_TYPES)
+        SCHEMA_PARSE_ENUM(key->default_preset,
+                          SYSTEM_ASSIGNABLE_SETTINGS_PRESETS)
+        PARSE_BYTE_INTO_VALUE(key->num_capability_presets)
+        key->capability_presets = presets;
+
+        for (capability_preset_t* preset = presets;
+             preset != &presets[key->num_capability_presets];
+             preset++)
+        {
+            SCHEMA_PARSE_ENUM(preset->preset,
+                              SYSTEM_ASSIGNABLE_SETTINGS_PRESETS)
+            PARSE_BYTE_INTO_VALUE(preset->num_capability_actions)
+            preset->capability_actions = actions;
+
+            for (capability_action_t* action = actions;
+                 action != &actions[preset->num_capability_actions];
+                 action++)
             {
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR:
-                    PARSE_ENUM_INTO_PACKET(vibrator.setting_type)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_VIBRATOR_SETTING_TYPE_ON_OFF)
-                    PARSE_ENUM_END
-                    PARSE_ENUM_INTO_PACKET(vibrator.setting_value)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_VIBRATOR_SETTING_VALUE_OFF)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_VIBRATOR_SETTING_VALUE_ON)
-                    PARSE_ENUM_END
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE:
-                    PARSE_ENUM_INTO_PACKET(power_saving_mode.setting_type)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_POWER_SAVING_MODE_SETTING_TYPE_ON_OFF)
-                    PARSE_ENUM_END
-                    PARSE_ENUM_INTO_PACKET(power_saving_mode.setting_value)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_POWER_SAVING_MODE_SETTING_VALUE_OFF)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_POWER_SAVING_MODE_SETTING_VALUE_ON)
-                    PARSE_ENUM_END
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING:
-                    PARSE_ENUM_INTO_PACKET(control_by_wearing.setting_type)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_CONTROL_BY_WEARING_SETTING_TYPE_ON_OFF)
-                    PARSE_ENUM_END
-                    PARSE_ENUM_INTO_PACKET(control_by_wearing.setting_value)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_CONTROL_BY_WEARING_SETTING_VALUE_OFF)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_CONTROL_BY_WEARING_SETTING_VALUE_ON)
-                    PARSE_ENUM_END
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF:
-                    PARSE_ENUM_INTO_PACKET(auto_power_off.parameter_type)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_PARAMETER_TYPE_ACTIVE_AND_SELECT_TIME_ID)
-                    PARSE_ENUM_END
-                    PARSE_ENUM_INTO_PACKET(auto_power_off.element_id)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_5_MIN)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_30_MIN)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_60_MIN)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_180_MIN)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_WHEN_REMOVED_FROM_EARS)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_DISABLE)
-                    PARSE_ENUM_END
-                    PARSE_ENUM_INTO_PACKET(auto_power_off.select_time_element_id)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_5_MIN)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_30_MIN)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_60_MIN)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_IN_180_MIN)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_WHEN_REMOVED_FROM_EARS)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_AUTO_POWER_OFF_ELEMENT_ID_POWER_OFF_DISABLE)
-                    PARSE_ENUM_END
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE:
-                    PARSE_ENUM_INTO_PACKET(smart_talking_mode.setting_type)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_SETTING_TYPE_ON_OFF)
-                    PARSE_ENUM_END
-                    PARSE_ENUM_INTO_PACKET(smart_talking_mode.setting_value)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_SETTING_VALUE_OFF)
-                        PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_SMART_TALKING_MODE_SETTING_VALUE_ON)
-                    PARSE_ENUM_END
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS:
-                    PARSE_BYTE_INTO_PACKET(assignable_settings.num_presets)
-
-                    PARSE_FOR_EACH_IN_PACKET(
-                            assignable_settings.num_presets,
-                            assignable_settings.presets,
-                            mdr_packet_system_assignable_settings_preset_t,
-                            preset)
-                        
-                        PARSE_ENUM_INTO_VALUE(*preset)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_AMBIENT_SOUND_CONTROL)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_VOLUME_CONTROL)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_PLAYBACK_CONTROL)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_VOICE_RECOGNITION)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_GOOGLE_ASSISTANT)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_AMAZON_ALEXA)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_TENCENT_XIAOWEI)
-                            PARSE_ENUM_FIELD(MDR_PACKET_SYSTEM_ASSIGNABLE_SETTINGS_PRESET_NO_FUNCTION)
-                        PARSE_ENUM_END
-
-                    PARSE_FOR_EACH_END
-
-                    break;
+                SCHEMA_PARSE_ENUM(action->action,
+                                  SYSTEM_ASSIGNABLE_SETTINGS_ACTIONS)
+                SCHEMA_PARSE_ENUM(action->function,
+                                  SYSTEM_ASSIGNABLE_SETTINGS_FUNCTIONS)
             }
 
-#undef PACKET_FIELD
-            break;
+            actions += preset->num_capability_actions;
+        }
 
-        default:
-            INVALID_FRAME
+        presets += key->num_capability_presets;
     }
 
-    return packet;
+    *offset_ptr = offset;
+    return value;
 }
 
-static mdr_frame_t* mdr_packet_system_to_frame(mdr_packet_t* packet)
+static size_t assignable_settings_capability_size(
+        mdr_packet_system_capability_assignable_settings_t* value)
 {
-    WRITE_INIT(packet)
-    int length;
-
-    switch (packet->type)
-    {
-        case MDR_PACKET_SYSTEM_GET_CAPABILITY:
-#define PACKET_FIELD system_get_capability
-
-            WRITE_START(1)
-            WRITE_FIELD(inquired_type)
-
-            break;
-
-#undef PACKET_FIELD
-
-        case MDR_PACKET_SYSTEM_RET_CAPABILITY:
-#define PACKET_FIELD system_ret_capability
-
-            switch (packet->data.system_ret_capability.inquired_type)
-            {
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR:
-                    WRITE_START(2)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(vibrator.setting_type)
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE:
-                    WRITE_START(2)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(power_saving_mode.setting_type)
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING:
-                    WRITE_START(2)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(control_by_wearing.setting_type)
-
-                    break;
+    size_t length = 0;
 
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF:
-                    WRITE_START(2 + FIELD(auto_power_off.element_id_count))
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(auto_power_off.element_id_count)
-                    WRITE_FOR_EACH_IN_PACKET(
-                            auto_power_off.element_id_count,
-                            auto_power_off.element_ids,
-                            mdr_packet_system_auto_power_off_element_id_t,
-                            element_id)
+    SYSTEM_ASSIGNABLE_SETTINGS_CAPABILITY_KEYS(SCHEMA_SIZE, (*value))
 
-                        WRITE_BYTE(*element_id)
-
-                    WRITE_FOR_EACH_END
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE:
-                    WRITE_START(11)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(smart_talking_mode.setting_type)
-                    WRITE_FIELD(smart_talking_mode.preview_type)
-                    WRITE_FIELD(smart_talking_mode.detail_setting)
-                    WRITE_FIELD(smart_talking_mode.detection_sensitivity_type)
-                    WRITE_FIELD(smart_talking_mode.voice_focus_type)
-                    WRITE_FIELD(smart_talking_mode.mode_out_time_type_t)
-                    WRITE_FIELD(smart_talking_mode.timeouts[0])
-                    WRITE_FIELD(smart_talking_mode.timeouts[1])
-                    WRITE_FIELD(smart_talking_mode.timeouts[2])
-                    WRITE_FIELD(smart_talking_mode.timeouts[3])
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS:
-                    length = 2;
-
-                    WRITE_FOR_EACH_IN_PACKET(
-                            assignable_settings.num_capability_keys,
-                            assignable_settings.capability_keys,
-                            mdr_packet_system_assignable_settings_capability_key_t,
-                            capability_key)
-
-                        length += 4;
-
-                        WRITE_FOR_EACH_IN_VALUE(
-                            capability_key->num_capability_presets,
-                            capability_key->capability_presets,
-                            mdr_packet_system_assignable_settings_capability_preset_t,
-                            capability_preset)
-
-                            length += 2;
-
-                            length += capability_preset->num_capability_actions
-                                * 2;
-
-                        WRITE_FOR_EACH_END
-
-                    WRITE_FOR_EACH_END
-
-                    WRITE_START(length)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(assignable_settings.num_capability_keys)
-
-                    WRITE_FOR_EACH_IN_PACKET(
-                            assignable_settings.num_capability_keys,
-                            assignable_settings.capability_keys,
-                            mdr_packet_system_assignable_settings_capability_key_t,
-                            capability_key)
-
-                        WRITE_BYTE(capability_key->key)
-                        WRITE_BYTE(capability_key->key_type)
-                        WRITE_BYTE(capability_key->default_preset)
-                        WRITE_BYTE(capability_key->num_capability_presets)
-
-                        WRITE_FOR_EACH_IN_VALUE(
-                                capability_key->num_capability_presets,
-                                capability_key->capability_presets,
-                                mdr_packet_system_assignable_settings_capability_preset_t,
-                                capability_preset)
-
-                            WRITE_BYTE(capability_preset->preset)
-                            WRITE_BYTE(capability_preset->num_capability_actions)
-
-                            WRITE_FOR_EACH_IN_VALUE(
-                                    capability_preset->num_capability_actions,
-                                    capability_preset->capability_actions,
-                                    mdr_packet_system_assignable_settings_capability_action_t,
-                                    capability_action)
-
-                                WRITE_BYTE(capability_action->action)
-                                WRITE_BYTE(capability_action->function)
-
-                            WRITE_FOR_EACH_END
-
-                        WRITE_FOR_EACH_END
-
-                    WRITE_FOR_EACH_END
-
-                    break;
-            }
-
-            break;
-
-#undef PACKET_FIELD
-
-        case MDR_PACKET_SYSTEM_GET_PARAM:
-#define PACKET_FIELD system_get_param
-
-            WRITE_START(1)
-            WRITE_FIELD(inquired_type)
-
-#undef PACKET_FIELD
-
-            break;
-
-        case MDR_PACKET_SYSTEM_RET_PARAM:
-        case MDR_PACKET_SYSTEM_SET_PARAM:
-        case MDR_PACKET_SYSTEM_NTFY_PARAM:
-#define PACKET_FIELD system_ret_param
-
-            switch (packet->data.system_ret_param.inquired_type)
-            {
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR:
-                    WRITE_START(3)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(vibrator.setting_type)
-                    WRITE_FIELD(vibrator.setting_value)
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE:
-                    WRITE_START(3)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(power_saving_mode.setting_type)
-                    WRITE_FIELD(power_saving_mode.setting_value)
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING:
-                    WRITE_START(3)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(control_by_wearing.setting_type)
-                    WRITE_FIELD(control_by_wearing.setting_value)
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF:
-                    WRITE_START(4)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(auto_power_off.parameter_type)
-                    WRITE_FIELD(auto_power_off.element_id)
-                    WRITE_FIELD(auto_power_off.select_time_element_id)
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE:
-                    WRITE_START(3)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(smart_talking_mode.setting_type)
-                    WRITE_FIELD(smart_talking_mode.setting_value)
-
-                    break;
-
-                case MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS:
-                    length = 2 + FIELD(assignable_settings.num_presets);
-
-                    WRITE_START(length)
-                    WRITE_FIELD(inquired_type)
-                    WRITE_FIELD(assignable_settings.num_presets)
-
-                    WRITE_FOR_EACH_IN_PACKET(
-                            assignable_settings.num_presets,
-                            assignable_settings.presets,
-                            mdr_packet_system_assignable_settings_preset_t,
-                            preset)
-
-                        WRITE_BYTE(*preset)
-
-                    WRITE_FOR_EACH_END
-
-                    break;
-            }
+    return length;
+}
 
-#undef PACKET_FIELD
+static void assignable_settings_capability_write(
+        mdr_packet_system_capability_assignable_settings_t* value,
+        uint8_t* payload,
+        uint32_t* offset_ptr)
+{
+    uint32_t offset = *offset_ptr;
 
-            break;
+    SYSTEM_ASSIGNABLE_SETTINGS_CAPABILITY_KEYS(SCHEMA_WRITE, (*value))
 
-        default:
-            errno = MDR_E_INVALID_PACKET;
-            return NULL;
-    }
+    *offset_ptr = offset;
+}
 
-    return frame;
+static void assignable_settings_capability_wire(
+        mdr_packet_system_capability_assignable_settings_t* value,
+        wire_t* wire)
+{
+    SYSTEM_ASSIGNABLE_SETTINGS_CAPABILITY_KEYS(SCHEMA_WIRE, (*value))
 }
 
+#define SYSTEM_GET_CAPABILITY(OP, p) \
+    OP##_ENUM(p.inquired_type, SYSTEM_INQUIRED_TYPES)
+
+#define SYSTEM_RET_CAPABILITY(OP, p) \
+    OP##_ENUM(p.inquired_type, SYSTEM_INQUIRED_TYPES) \
+    OP##_SWITCH(p.inquired_type) \
+        OP##_CASE(MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR) \
+            OP##_ENUM(p.vibrator.setting_type, SYSTEM_VIBRATOR_SETTING_TYPES) \
+        OP##_CASE(MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE) \
+            OP##_ENUM(p.power_saving_mode.setting_type, \
+                      SYSTEM_POWER_SAVING_MODE_SETTING_TYPES) \
+        OP##_CASE(MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING) \
+            OP##_ENUM(p.control_by_wearing.setting_type, \
+                      SYSTEM_CONTROL_BY_WEARING_SETTING_TYPES) \
+        OP##_CASE(MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF) \
+            OP##_ARRAY(p.auto_power_off.element_id_count, \
+                       p.auto_power_off.element_ids, \
+                       mdr_packet_system_auto_power_off_element_id_t, \
+                       element_id) \
+                OP##_ENUM(*element_id, SYSTEM_AUTO_POWER_OFF_ELEMENT_IDS) \
+            OP##_ARRAY_END \
+        OP##_CASE(MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE) \
+            OP##_ENUM(p.smart_talking_mode.setting_type, \
+                      SYSTEM_SMART_TALKING_MODE_SETTING_TYPES) \
+            OP##_ENUM(p.smart_talking_mode.preview_type, \
+                      SYSTEM_SMART_TALKING_MODE_PREVIEW_TYPES) \
+            OP##_ENUM(p.smart_talking_mode.detail_setting, \
+                      SYSTEM_SMART_TALKING_MODE_DETAIL_SETTING_TYPES) \
+            OP##_ENUM(p.smart_talking_mode.detection_sensitivity_type, \
+                      SYSTEM_SMART_TALKING_MODE_DETECTION_SENSITIVITY_TYPES) \
+            OP##_ENUM(p.smart_talking_mode.voice_focus_type, \
+                      SYSTEM_SMART_TALKING_MODE_VOICE_FOCUS_TYPES) \
+            OP##_ENUM(p.smart_talking_mode.mode_out_time_type_t, \
+                      SYSTEM_SMART_TALKING_MODE_MODE_OUT_TIME_TYPES) \
+            OP##_BYTE(p.smart_talking_mode.timeouts[0]) \
+            OP##_BYTE(p.smart_talking_mode.timeouts[1]) \
+            OP##_BYTE(p.smart_talking_mode.timeouts[2]) \
+            OP##_BYTE(p.smart_talking_mode.timeouts[3]) \
+        OP##_CASE(MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS) \
+            OP##_CUSTOM(p.assignable_settings, \
+                        assignable_settings_capability) \
+    OP##_SWITCH_END
+
+#define SYSTEM_GET_PARAM(OP, p) \
+    OP##_ENUM(p.inquired_type, SYSTEM_INQUIRED_TYPES)
+
+#define SYSTEM_PARAM(OP, p) \
+    OP##_ENUM(p.inquired_type, SYSTEM_INQUIRED_TYPES) \
+    OP##_SWITCH(p.inquired_type) \
+        OP##_CASE(MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR) \
+            OP##_ENUM(p.vibrator.setting_type, SYSTEM_VIBRATOR_SETTING_TYPES) \
+            OP##_ENUM(p.vibrator.setting_value, \
+                      SYSTEM_VIBRATOR_SETTING_VALUES) \
+        OP##_CASE(MDR_PACKET_SYSTEM_INQUIRED_TYPE_POWER_SAVING_MODE) \
+            OP##_ENUM(p.power_saving_mode.setting_type, \
+                      SYSTEM_POWER_SAVING_MODE_SETTING_TYPES) \
+            OP##_ENUM(p.power_saving_mode.setting_value, \
+                      SYSTEM_POWER_SAVING_MODE_SETTING_VALUES) \
+        OP##_CASE(MDR_PACKET_SYSTEM_INQUIRED_TYPE_CONTROL_BY_WEARING) \
+            OP##_ENUM(p.control_by_wearing.setting_type, \
+                      SYSTEM_CONTROL_BY_WEARING_SETTING_TYPES) \
+            OP##_ENUM(p.control_by_wearing.setting_value, \
+                      SYSTEM_CONTROL_BY_WEARING_SETTING_VALUES) \
+        OP##_CASE(MDR_PACKET_SYSTEM_INQUIRED_TYPE_AUTO_POWER_OFF) \
+            OP##_ENUM(p.auto_power_off.parameter_type, \
+                      SYSTEM_AUTO_POWER_OFF_PARAMETER_TYPES) \
+            OP##_ENUM(p.auto_power_off.element_id, \
+                      SYSTEM_AUTO_POWER_OFF_ELEMENT_IDS) \
+            OP##_ENUM(p.auto_power_off.select_time_element_id, \
+                      SYSTEM_AUTO_POWER_OFF_ELEMENT_IDS) \
+        OP##_CASE(MDR_PACKET_SYSTEM_INQUIRED_TYPE_SMART_TALKING_MODE) \
+            OP##_ENUM(p.smart_talking_mode.setting_type, \
+                      SYSTEM_SMART_TALKING_MODE_SETTING_TYPES) \
+            OP##_ENUM(p.smart_talking_mode.setting_value, \
+                      SYSTEM_SMART_TALKING_MODE_SETTING_VALUES) \
+        OP##_CASE(MDR_PACKET_SYSTEM_INQUIRED_TYPE_ASSIGNABLE_SETTINGS) \
+            OP##_ARRAY(p.assignable_settings.num_presets, \
+                       p.assignable_settings.presets, \
+                       mdr_packet_system_assignable_settings_preset_t, \
+                       preset) \
+                OP##_ENUM(*preset, SYSTEM_ASSIGNABLE_SETTINGS_PRESETS) \
+            OP##_ARRAY_END \
+    OP##_SWITCH_END
+
+#define SYSTEM_PACKETS(P) \
+    P(MDR_PACKET_SYSTEM_GET_CAPABILITY, \
+      system_get_capability, \
+      SYSTEM_GET_CAPABILITY) \
+    P(MDR_PACKET_SYSTEM_RET_CAPABILITY, \
+      system_ret_capability, \
+      SYSTEM_RET_CAPABILITY) \
+    P(MDR_PACKET_SYSTEM_GET_PARAM, system_get_param, SYSTEM_GET_PARAM) \
+    P(MDR_PACKET_SYSTEM_RET_PARAM, system_ret_param, SYSTEM_PARAM) \
+    P(MDR_PACKET_SYSTEM_SET_PARAM, system_ret_param, SYSTEM_PARAM) \
+    P(MDR_PACKET_SYSTEM_NTFY_PARAM, system_ret_param, SYSTEM_PARAM)
+
+SCHEMA_CODEC(system, SYSTEM_PACKETS)
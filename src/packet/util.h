@@ -24,38 +24,64 @@
 #define __MDR_PACKET_UTIL_H__
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
 #include <string.h>
+#include <errno.h>
 #include <stdio.h>
 
 #include <mdr/frame.h>
 #include <mdr/packet.h>
 
-#define FIELD(field) \
-    packet->data.PACKET_FIELD.field
-
-#define min(a, b) ((a) < (b) ? (a) : (b))
+/*
+ * A block of memory packets are decoded into, the packet and everything
+ * it points to are bump-allocated from [base, base + size).
+ *
+ * If `borrow` is set strings point into the frame payload
+ * instead of being copied into the arena.
+ */
+typedef struct
+{
+    uint8_t* base;
+    size_t size;
+    size_t used;
+    bool borrow;
+    // Number of allocations made, including empty ones.
+    size_t allocations;
+}
+parse_arena_t;
+
+#define PARSE_ARENA_ALIGN _Alignof(max_align_t)
 
-#define FREE_FIELD(field) \
-    free(packet->data.PACKET_FIELD.field);
+/*
+ * Allocate `size` zeroed bytes from `arena`.
+ *
+ * Returns NULL and sets errno to ENOBUFS if the arena is too small.
+ */
+static void* parse_arena_alloc(parse_arena_t* arena, size_t size)
+{
+    size_t start = (arena->used + PARSE_ARENA_ALIGN - 1)
+                 & ~(PARSE_ARENA_ALIGN - 1);
+
+    if (start > arena->size || size > arena->size - start)
+    {
+        errno = ENOBUFS;
+        return NULL;
+    }
 
-#define FREE_FOR_EACH_IN_VALUE(count, field, field_type, field_name) \
-    if ((field) != NULL) \
-    { \
-        for (field_type* field_name = (field); \
-                field_name != &(field)[count]; \
-                field_name++) \
-        { \
+    arena->used = start + size;
+    arena->allocations++;
 
-#define FREE_FOR_EACH_IN_PACKET(count_field, field, field_type, field_name) \
-    FREE_FOR_EACH_IN_VALUE(packet->data.PACKET_FIELD.count_field, \
-                           packet->data.PACKET_FIELD.field, \
-                           field_type, \
-                           field_name)
+    void* value = &arena->base[start];
+    memset(value, 0, size);
 
-#define FREE_FOR_EACH_END \
-        } \
-    }
+    return value;
+}
 
+/*
+ * Packets are decoded into `arena`, which is released as a whole
+ * by the caller on failure.
+ */
 #define PARSE_INIT(frame) \
     uint8_t* payload = mdr_frame_payload(frame); \
     uint32_t payload_length = frame->payload_length; \
@@ -65,21 +91,16 @@
         return NULL; \
     } \
     uint32_t offset = 1; \
-    mdr_packet_t* packet = malloc(sizeof(mdr_packet_t)); \
+    mdr_packet_t* packet = parse_arena_alloc(arena, sizeof(mdr_packet_t)); \
     if (packet == NULL) \
     { \
         return NULL; \
     } \
-    memset(packet, 0, sizeof(mdr_packet_t)); \
     packet->type = payload[0];
 
 #ifdef __DEBUG
 #define INVALID_FRAME \
     { \
-        if (packet != NULL) \
-        { \
-            mdr_packet_free(packet); \
-        } \
         printf("Parse error at " __FILE__ ":%d\n", __LINE__); \
         errno = MDR_E_INVALID_FRAME; \
         return NULL; \
@@ -87,10 +108,6 @@
 #else
 #define INVALID_FRAME \
     { \
-        if (packet != NULL) \
-        { \
-            mdr_packet_free(packet); \
-        } \
         errno = MDR_E_INVALID_FRAME; \
         return NULL; \
     }
@@ -104,30 +121,25 @@
     value = payload[offset]; \
     offset++;
 
-#define PARSE_BYTE_INTO_PACKET(field) \
-    PARSE_BYTE_INTO_VALUE(FIELD(field))
-
 #define PARSE_BYTES_INTO_VALUE(value, length) \
     if (offset + (length) > payload_length) \
     { \
         INVALID_FRAME; \
     } \
-    (value) = malloc(length); \
-    if ((value) == NULL) \
+    if (arena->borrow) \
     { \
-        mdr_packet_free(packet); \
-        return NULL; \
+        (value) = &payload[offset]; \
     } \
-    memcpy((value), &payload[offset], length); \
-    offset += length;
-
-#define PARSE_BYTES_INTO_PACKET(field, length) \
-    PARSE_BYTES_INTO_VALUE(FIELD(field), length)
-
-#define PARSE_ENUM_INTO_PACKET(field) \
-    PARSE_BYTE_INTO_PACKET(field) \
-    switch (packet->data.PACKET_FIELD.field) \
+    else \
     { \
+        (value) = parse_arena_alloc(arena, length); \
+        if ((value) == NULL) \
+        { \
+            return NULL; \
+        } \
+        memcpy((value), &payload[offset], length); \
+    } \
+    offset += length;
 
 #define PARSE_ENUM_INTO_VALUE(value) \
     PARSE_BYTE_INTO_VALUE(value) \
@@ -143,38 +155,30 @@
     }
 
 #define PARSE_ALLOC_VALUE(value, size) \
-    (value) = malloc(size); \
+    (value) = parse_arena_alloc(arena, size); \
     if ((value) == NULL) \
     { \
-        mdr_packet_free(packet); \
         return NULL; \
-    } \
-    memset((value), 0, size);
-
-
-#define PARSE_ALLOC_FIELD(field, size) \
-        PARSE_ALLOC_VALUE(FIELD(field), size)
+    }
 
+/*
+ * Every element takes at least one byte of the payload, so a count larger
+ * than what remains is rejected before anything is allocated for it.
+ */
 #define PARSE_FOR_EACH_INTO_VALUE(count, \
                                   value, \
                                   value_type, \
                                   value_name) \
+    if ((count) > payload_length - offset) \
+    { \
+        INVALID_FRAME; \
+    } \
     PARSE_ALLOC_VALUE(value, sizeof(value_type) * (count)); \
     for (value_type* value_name = (value); \
             value_name != &(value)[count]; \
             value_name++) \
     { \
 
-#define PARSE_FOR_EACH_IN_PACKET(count_field, \
-                                 field, \
-                                 field_type, \
-                                 field_name) \
-    PARSE_FOR_EACH_INTO_VALUE( \
-            packet->data.PACKET_FIELD.count_field, \
-            packet->data.PACKET_FIELD.field, \
-            field_type, \
-            field_name)
-
 #define PARSE_FOR_EACH_END \
     }
 
@@ -183,26 +187,17 @@
     uint8_t* payload = NULL; \
     uint32_t offset = 0;
 
-#define WRITE_ALLOC_FRAME(size) \
-    frame = malloc(MDR_FRAME_EMPTY_LEN + size); \
-    if (frame == NULL) \
-    { \
-        return NULL; \
-    } \
-    frame->data_type = MDR_FRAME_DATA_TYPE_DATA_MDR; \
-    frame->sequence_id = 0; \
-    frame->payload_length = size; \
-    payload = mdr_frame_payload(frame);
-
+/*
+ * Frames are acquired from `pool`, which may be NULL.
+ */
 #define WRITE_START(size) \
-    frame = malloc(MDR_FRAME_EMPTY_LEN + 1 + (size)); \
+    frame = mdr_frame_pool_acquire(pool, 1 + (size)); \
     if (frame == NULL) \
     { \
         return NULL; \
     } \
     frame->data_type = MDR_FRAME_DATA_TYPE_DATA_MDR; \
     frame->sequence_id = 0; \
-    frame->payload_length = 1 + (size); \
     payload = mdr_frame_payload(frame); \
     payload[0] = packet->type; \
     offset = 1;
@@ -211,28 +206,16 @@
     payload[offset] = byte; \
     offset++;
 
-#define WRITE_FIELD(field) \
-    WRITE_BYTE(packet->data.PACKET_FIELD.field)
-
 #define WRITE_BYTES(bytes, length) \
     memcpy(&payload[offset], (bytes), (length)); \
     offset += (length);
 
-#define WRITE_FIELD_BYTES(field, length) \
-    WRITE_BYTES(FIELD(field), length)
-
 #define WRITE_FOR_EACH_IN_VALUE(count, field, field_type, field_name) \
     for (field_type* field_name = (field); \
             field_name != &(field)[count]; \
             field_name++) \
     { \
 
-#define WRITE_FOR_EACH_IN_PACKET(count_field, field, field_type, field_name) \
-    WRITE_FOR_EACH_IN_VALUE(packet->data.PACKET_FIELD.count_field, \
-                           packet->data.PACKET_FIELD.field, \
-                           field_type, \
-                           field_name)
-
 #define WRITE_FOR_EACH_END \
     }
 
@@ -0,0 +1,101 @@
+/*
+ * libmdr - MDR protocol library
+ *
+ *  Copyright (C) 2021 Andreas Olofsson
+ *
+ *
+ * This file is part of libmdr.
+ *
+ * libmdr is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libmdr is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libmdr. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __MDR_PACKET_WIRE_H__
+#define __MDR_PACKET_WIRE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "../frameconn/escape.h"
+
+/*
+ * Writes an escaped frame straight into a buffer,
+ * summing the unescaped bytes into the checksum as it goes.
+ */
+typedef struct
+{
+    uint8_t* out;
+    size_t cap;
+    size_t len;
+    uint8_t checksum;
+    // Set once a write didn't fit, nothing more is written after that.
+    bool overflow;
+}
+wire_t;
+
+/*
+ * Write a start or end byte, which is neither escaped nor summed.
+ */
+static void wire_put_delimiter(wire_t* wire, uint8_t byte)
+{
+    if (wire->overflow || wire->cap - wire->len < 1)
+    {
+        wire->overflow = true;
+        return;
+    }
+
+    wire->out[wire->len] = byte;
+    wire->len++;
+}
+
+static void wire_put(wire_t* wire, uint8_t byte)
+{
+    wire->checksum += byte;
+
+    size_t escaped_len = IS_SPECIAL_BYTE(byte) ? 2 : 1;
+    if (wire->overflow || wire->cap - wire->len < escaped_len)
+    {
+        wire->overflow = true;
+        return;
+    }
+
+    if (escaped_len == 2)
+    {
+        wire->out[wire->len] = FRAME_ESCAPE_BYTE;
+        wire->out[wire->len + 1] = byte & ~FRAME_ESCAPE_MASK;
+    }
+    else
+    {
+        wire->out[wire->len] = byte;
+    }
+    wire->len += escaped_len;
+}
+
+static void wire_put_bytes(wire_t* wire, const uint8_t* bytes, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        wire->checksum += bytes[i];
+    }
+
+    if (wire->overflow || wire->cap - wire->len < escape_len(bytes, len))
+    {
+        wire->overflow = true;
+        return;
+    }
+
+    wire->len += escape_bytes(&wire->out[wire->len], bytes, len);
+}
+
+#endif /* __MDR_PACKET_WIRE_H__ */
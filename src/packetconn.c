@@ -24,75 +24,369 @@
 
 #include "mdr/errors.h"
 
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 #include <time.h>
 #include <errno.h>
 
 typedef struct
 {
+    // Raw requests and subscriptions are handed the payload bytes
+    // through `raw_result` instead of a decoded packet.
+    bool raw;
     mdr_packetconn_result_callback result;
+    mdr_packetconn_raw_result_callback raw_result;
     mdr_packetconn_error_callback error;
     void* user_data;
 }
 callbacks_t;
 
+typedef struct waiter waiter_t;
+
+/*
+ * The callbacks of a GET request which was coalesced with an identical
+ * request already in the queue.
+ */
+struct waiter
+{
+    callbacks_t callbacks;
+
+    waiter_t* next;
+};
+
 typedef struct request request_t;
 
 struct request
 {
-    mdr_frame_t*                     frame;
+    /*
+     * The request encoded as it's sent on the wire, with room for one
+     * more byte as setting the sequence id may grow it.
+     *
+     * Unless the request owns it, it's the frame of a template which
+     * is never changed, the sequence id is patched when it's sent.
+     */
+    uint8_t*                         wire;
+    size_t                           wire_len;
+    bool                             owns_wire;
+    uint8_t                          sequence_id;
+    mdr_packet_type_t                packet_type;
+    // SET requests which haven't been sent can be replaced by a newer
+    // request for the same setting, identified by the type and `extra`.
+    bool                             supersedable;
+    uint8_t                          extra;
+    mdr_packetconn_priority_t        priority;
     struct timespec                  timeout;
     int                              attempts;
     bool                             acked;
+    // When the request was last sent, or ACK'd once it has been.
+    struct timespec                  timestamp;
     callbacks_t                      callbacks;
     mdr_packetconn_reply_specifier_t expected_reply;
+    // Completed along with the request, in the order they were made.
+    waiter_t*                        waiters;
 
     request_t* next;
 };
 
+/*
+ * The largest encoded frame a template may have.
+ */
+#define PACKET_TEMPLATE_MAX_LEN 64
+
+struct mdr_packetconn_template
+{
+    mdr_packet_type_t packet_type;
+    // Encoded with sequence id 0.
+    uint8_t wire[PACKET_TEMPLATE_MAX_LEN];
+    size_t wire_len;
+};
+
 typedef struct subscription subscription_t;
 
 struct subscription
 {
     callbacks_t                      callbacks;
+    // `extra` is 0 for packet types without an extra parameter.
     mdr_packetconn_reply_specifier_t specifier;
 
-    subscription_t* next;
+    // Neighbours in the subscription's bucket.
+    subscription_t* prev, *next;
 };
 
+/*
+ * Number of buckets subscriptions are indexed in by packet type and
+ * extra parameter, a power of two.
+ */
+#define PACKET_SUBSCRIPTION_BUCKETS 64
+
+typedef struct
+{
+    subscription_t* head, *tail;
+}
+subscription_bucket_t;
+
+#define PACKET_NUM_PRIORITIES (MDR_PACKETCONN_PRIORITY_BACKGROUND + 1)
+
+typedef struct
+{
+    request_t* head, *tail;
+}
+request_queue_t;
+
+/*
+ * A smoothed round-trip time and its mean deviation, estimated from
+ * measured round trips as described by Jacobson, in nanoseconds.
+ */
+typedef struct
+{
+    int64_t srtt;
+    int64_t rttvar;
+    // No round trip has been measured yet.
+    bool    initial;
+    // A timeout set by the user to use instead of the estimate, or 0.
+    int64_t fixed;
+}
+rtt_estimator_t;
+
 struct mdr_packetconn
 {
     mdr_frameconn_t* fconn;
+    // The frame pool of `fconn`, received frames are released to it.
+    mdr_frame_pool_t* frame_pool;
 
     uint8_t next_sequence_id;
 
-    request_t*      request, *request_queue_tail;
-    subscription_t* subscription, *subscription_list_tail;
+    // The request being sent, followed by the requests queued
+    // for each priority.
+    request_t*      request;
+    request_queue_t request_queues[PACKET_NUM_PRIORITIES];
+    // Subscriptions in order of subscribing,
+    // bucketed by the packets they match.
+    subscription_bucket_t subscriptions[PACKET_SUBSCRIPTION_BUCKETS];
+
+    // The priority of requests made from now on.
+    mdr_packetconn_priority_t request_priority;
+
+    // Time from sending a request to its ACK,
+    // and from the ACK to the reply.
+    rtt_estimator_t ack_rtt, reply_rtt;
+    int max_tries;
+
+    int frame_budget;
+
+    // When to release the I/O buffers of `fconn` unless there's traffic.
+    struct timespec buffer_release_time;
 };
 
 /*
- * Number of times to try sending a packet before giving up.
+ * Default and maximum number of times to try sending a packet
+ * before giving up.
  */
-#define PACKET_MAX_TRIES 3
+#define PACKET_DEFAULT_MAX_TRIES 3
+#define PACKET_MAX_TRIES 16
 
 /*
- * Time to wait before re-sending an un-ACKd packet (0.5 s).
+ * Default and maximum number of received frames handled per call to
+ * `mdr_packetconn_process_by_availability`.
  */
-static const struct timespec packet_ack_timeout = {
-    .tv_sec = 1,
-    .tv_nsec = 0,
-};
+#define PACKET_DEFAULT_FRAME_BUDGET 16
+#define PACKET_MAX_FRAME_BUDGET 64
+
+/*
+ * Size of the stack buffer received packets are decoded into,
+ * larger packets are allocated.
+ */
+#define PACKET_VIEW_SIZE 1024
 
 /*
- * Time to wait after a request being ACKd to consider the reply lost (1.0s).
+ * Time to wait for an ACK, or for the reply after it, until a round trip
+ * has been measured (1.0 s).
  */
-static struct timespec packet_reply_timeout = {
-    .tv_sec = 1,
+#define PACKET_INITIAL_TIMEOUT 1000000000LL
+
+/*
+ * Bounds of the estimated time to wait for an ACK or reply (0.2 s to
+ * 8.0 s), also bounding the back-off of re-sent requests.
+ */
+#define PACKET_MIN_TIMEOUT 200000000LL
+#define PACKET_MAX_TIMEOUT 8000000000LL
+
+/*
+ * Time without any traffic after which the connection's I/O buffers
+ * are given back (5.0 s).
+ */
+static const struct timespec packet_buffer_idle_timeout = {
+    .tv_sec = 5,
     .tv_nsec = 0,
 };
 
+/*
+ * Get the request sent after `request`, the current request is followed
+ * by the queued requests in order of priority.
+ */
+static request_t* request_after(mdr_packetconn_t* conn, request_t* request)
+{
+    int priority = 0;
+
+    if (request != conn->request)
+    {
+        if (request->next != NULL)
+        {
+            return request->next;
+        }
+        priority = request->priority + 1;
+    }
+
+    for (; priority < PACKET_NUM_PRIORITIES; priority++)
+    {
+        if (conn->request_queues[priority].head != NULL)
+        {
+            return conn->request_queues[priority].head;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Add a request to the end of the queue of its priority.
+ */
+static void append_request(mdr_packetconn_t* conn, request_t* request)
+{
+    request_queue_t* queue = &conn->request_queues[request->priority];
+
+    request->next = NULL;
+    if (queue->tail == NULL)
+    {
+        queue->head = queue->tail = request;
+    }
+    else
+    {
+        queue->tail->next = request;
+        queue->tail = request;
+    }
+}
+
+/*
+ * Raise the priority of a request to `priority`, moving it to the end of
+ * the queue of that priority unless it's already being sent.
+ */
+static void raise_priority(mdr_packetconn_t* conn,
+                           request_t* request,
+                           mdr_packetconn_priority_t priority)
+{
+    if (priority >= request->priority)
+    {
+        return;
+    }
+
+    if (request != conn->request)
+    {
+        request_queue_t* queue = &conn->request_queues[request->priority];
+
+        request_t* previous = NULL;
+        for (request_t* queued = queue->head;
+             queued != request;
+             queued = queued->next)
+        {
+            previous = queued;
+        }
+
+        if (previous == NULL)
+        {
+            queue->head = request->next;
+        }
+        else
+        {
+            previous->next = request->next;
+        }
+
+        if (queue->tail == request)
+        {
+            queue->tail = previous;
+        }
+    }
+
+    request->priority = priority;
+
+    if (request != conn->request)
+    {
+        append_request(conn, request);
+    }
+}
+
 static struct timespec timespec_add(struct timespec, struct timespec);
 static struct timespec timespec_sub(struct timespec, struct timespec);
 static int timespec_compare(struct timespec, struct timespec);
+static int64_t timespec_to_ns(struct timespec);
+static struct timespec timespec_from_ns(int64_t);
+
+static void rtt_estimator_init(rtt_estimator_t* estimator)
+{
+    estimator->srtt = 0;
+    estimator->rttvar = 0;
+    estimator->initial = true;
+    estimator->fixed = 0;
+}
+
+/*
+ * Update the estimate with a measured round trip, gains of 1/8 for the
+ * round-trip time and 1/4 for its deviation (RFC 6298).
+ */
+static void rtt_estimator_sample(rtt_estimator_t* estimator,
+                                 struct timespec sent,
+                                 struct timespec now)
+{
+    int64_t rtt = timespec_to_ns(timespec_sub(now, sent));
+    if (rtt < 0) return;
+
+    if (estimator->initial)
+    {
+        estimator->srtt = rtt;
+        estimator->rttvar = rtt / 2;
+        estimator->initial = false;
+    }
+    else
+    {
+        int64_t error = rtt - estimator->srtt;
+        estimator->rttvar += ((error < 0 ? -error : error)
+                              - estimator->rttvar) / 4;
+        estimator->srtt += error / 8;
+    }
+}
+
+/*
+ * Get the time to wait for a round trip after `attempts` tries, doubled
+ * for every re-try unless set by the user.
+ */
+static struct timespec rtt_estimator_timeout(rtt_estimator_t* estimator,
+                                             int attempts)
+{
+    if (estimator->fixed > 0)
+    {
+        return timespec_from_ns(estimator->fixed);
+    }
+
+    int64_t timeout;
+    if (estimator->initial)
+    {
+        timeout = PACKET_INITIAL_TIMEOUT;
+    }
+    else
+    {
+        timeout = estimator->srtt + 4 * estimator->rttvar;
+        if (timeout < PACKET_MIN_TIMEOUT) timeout = PACKET_MIN_TIMEOUT;
+    }
+
+    for (int i = 1; i < attempts && timeout < PACKET_MAX_TIMEOUT; i++)
+    {
+        timeout *= 2;
+    }
+    if (timeout > PACKET_MAX_TIMEOUT) timeout = PACKET_MAX_TIMEOUT;
+
+    return timespec_from_ns(timeout);
+}
 
 mdr_packetconn_t* mdr_packetconn_new_from_sock(int sock)
 {
@@ -115,10 +409,32 @@ mdr_packetconn_t* mdr_packetconn_new_from_frameconn(mdr_frameconn_t* fconn)
     if (conn == NULL) return NULL;
 
     conn->fconn = fconn;
+    conn->frame_pool = mdr_frameconn_frame_pool(fconn);
     conn->next_sequence_id = 0;
 
-    conn->request = conn->request_queue_tail = NULL;
-    conn->subscription = conn->subscription_list_tail = NULL;
+    conn->request = NULL;
+    for (int priority = 0; priority < PACKET_NUM_PRIORITIES; priority++)
+    {
+        conn->request_queues[priority].head = NULL;
+        conn->request_queues[priority].tail = NULL;
+    }
+    for (int bucket = 0; bucket < PACKET_SUBSCRIPTION_BUCKETS; bucket++)
+    {
+        conn->subscriptions[bucket].head = NULL;
+        conn->subscriptions[bucket].tail = NULL;
+    }
+
+    conn->request_priority = MDR_PACKETCONN_PRIORITY_NORMAL;
+
+    conn->frame_budget = PACKET_DEFAULT_FRAME_BUDGET;
+
+    rtt_estimator_init(&conn->ack_rtt);
+    rtt_estimator_init(&conn->reply_rtt);
+    conn->max_tries = PACKET_DEFAULT_MAX_TRIES;
+
+    clock_gettime(CLOCK_MONOTONIC, &conn->buffer_release_time);
+    conn->buffer_release_time = timespec_add(conn->buffer_release_time,
+                                             packet_buffer_idle_timeout);
 
     return conn;
 }
@@ -131,7 +447,10 @@ static void mdr_packetconn_free_self(mdr_packetconn_t* conn)
              request != NULL;
              request = next)
         {
-            free(request->frame);
+            if (request->owns_wire)
+            {
+                free(request->wire);
+            }
 
             if (request->callbacks.error != NULL)
             {
@@ -139,21 +458,36 @@ static void mdr_packetconn_free_self(mdr_packetconn_t* conn)
                 request->callbacks.error(request->callbacks.user_data);
             }
 
-            next = request->next;
+            waiter_t* next_waiter = NULL;
+            for (waiter_t* waiter = request->waiters;
+                 waiter != NULL;
+                 waiter = next_waiter)
+            {
+                if (waiter->callbacks.error != NULL)
+                {
+                    errno = MDR_E_CLOSED;
+                    waiter->callbacks.error(waiter->callbacks.user_data);
+                }
+
+                next_waiter = waiter->next;
+                free(waiter);
+            }
+
+            next = request_after(conn, request);
             free(request);
         }
     }
 
+    for (int bucket = 0; bucket < PACKET_SUBSCRIPTION_BUCKETS; bucket++)
     {
         subscription_t* next = NULL;
-        for (subscription_t* subscription = conn->subscription;
+        for (subscription_t* subscription = conn->subscriptions[bucket].head;
              subscription != NULL;
              subscription = next)
         {
             next = subscription->next;
             free(subscription);
         }
-
     }
 
     free(conn);
@@ -173,6 +507,21 @@ void mdr_packetconn_free(mdr_packetconn_t* conn)
     mdr_packetconn_free_self(conn);
 }
 
+/*
+ * Get the poll timeout in milliseconds until `deadline`.
+ */
+static int poll_timeout(struct timespec deadline, struct timespec now)
+{
+    struct timespec timeout = timespec_sub(deadline, now);
+
+    if (timeout.tv_sec < 0)
+    {
+        return 0;
+    }
+
+    return timeout.tv_sec * 1000 + timeout.tv_nsec / 1000000;
+}
+
 mdr_poll_info mdr_packetconn_poll_info(mdr_packetconn_t* conn)
 {
     struct timespec now;
@@ -197,153 +546,144 @@ mdr_poll_info mdr_packetconn_poll_info(mdr_packetconn_t* conn)
     }
 
     poll_info.timeout = -1;
-    if (conn->request != NULL && conn->request->attempts != 0)
+    if (mdr_frameconn_waiting_read(conn->fconn))
     {
-        struct timespec timeout = timespec_sub(conn->request->timeout, now);
-
-        if (timeout.tv_sec < 0)
-        {
-            poll_info.timeout = 0;
-        }
-        else
-        {
-            poll_info.timeout = timeout.tv_sec * 1000
-                    + timeout.tv_nsec / 1000000;
-        }
+        // Frames left over by the frame budget, or input the transport
+        // has already received, won't make the socket readable.
+        poll_info.timeout = 0;
+    }
+    else if (conn->request != NULL && conn->request->attempts != 0)
+    {
+        poll_info.timeout = poll_timeout(conn->request->timeout, now);
+    }
+    else if (conn->request == NULL
+            && mdr_frameconn_has_buffers(conn->fconn))
+    {
+        poll_info.timeout = poll_timeout(conn->buffer_release_time, now);
     }
     
     return poll_info;
 }
 
-int mdr_packetconn_process(mdr_packetconn_t* conn)
+int mdr_packetconn_set_frame_budget(mdr_packetconn_t* conn, int budget)
 {
-    return mdr_packetconn_process_by_availability(conn, true, true);
+    if (budget < 1 || budget > PACKET_MAX_FRAME_BUDGET)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    conn->frame_budget = budget;
+    return 0;
 }
 
-static bool reply_specifier_matches(
-    mdr_packetconn_reply_specifier_t reply_spec,
-    mdr_packet_t* packet)
+int mdr_packetconn_set_request_priority(mdr_packetconn_t* conn,
+                                        mdr_packetconn_priority_t priority)
 {
-    if (packet->type != reply_spec.packet_type)
-        return false;
-
-    switch (reply_spec.packet_type)
+    if ((unsigned int) priority >= PACKET_NUM_PRIORITIES)
     {
-        case MDR_PACKET_CONNECT_GET_PROTOCOL_INFO:
-        case MDR_PACKET_CONNECT_RET_PROTOCOL_INFO:
-            return true;
-
-        case MDR_PACKET_CONNECT_GET_DEVICE_INFO:
-            return true;
-        case MDR_PACKET_CONNECT_RET_DEVICE_INFO:
-            return reply_spec.extra
-                    == packet->data.connect_ret_device_info.inquired_type;
-
-        case MDR_PACKET_CONNECT_GET_SUPPORT_FUNCTION:
-        case MDR_PACKET_CONNECT_RET_SUPPORT_FUNCTION:
-            return true;
-
-        case MDR_PACKET_COMMON_GET_BATTERY_LEVEL:
-            return true;
-
-        case MDR_PACKET_COMMON_RET_BATTERY_LEVEL:
-            return reply_spec.extra
-                    == packet->data.common_ret_battery_level.inquired_type;
-
-        case MDR_PACKET_COMMON_NTFY_BATTERY_LEVEL:
-            return reply_spec.extra
-                    == packet->data.common_ntfy_battery_level.inquired_type;
-
-        case MDR_PACKET_COMMON_SET_POWER_OFF:
-            return true;
-
-        case MDR_PACKET_COMMON_GET_CONNECTION_STATUS:
-            return true;
-
-        case MDR_PACKET_COMMON_RET_CONNECTION_STATUS:
-            return reply_spec.extra
-                    == packet->data.common_ret_connection_status.inquired_type;
-
-        case MDR_PACKET_COMMON_NTFY_CONNECTION_STATUS:
-            return reply_spec.extra
-                    == packet->data.common_ntfy_connection_status.inquired_type;
-
-        case MDR_PACKET_EQEBB_GET_CAPABILITY:
-            return true;
-
-        case MDR_PACKET_EQEBB_RET_CAPABILITY:
-            return reply_spec.extra
-                    == packet->data.eqebb_ret_capability.inquired_type;
-
-        case MDR_PACKET_EQEBB_GET_PARAM:
-            return true;
-
-        case MDR_PACKET_EQEBB_RET_PARAM:
-            return reply_spec.extra
-                    == packet->data.eqebb_ret_param.inquired_type;
-
-        case MDR_PACKET_EQEBB_SET_PARAM:
-            return reply_spec.extra
-                    == packet->data.eqebb_set_param.inquired_type;
-
-        case MDR_PACKET_EQEBB_NTFY_PARAM:
-            return reply_spec.extra
-                    == packet->data.eqebb_ntfy_param.inquired_type;
-
-        case MDR_PACKET_NCASM_GET_PARAM:
-            return true;
-
-        case MDR_PACKET_NCASM_RET_PARAM:
-            return reply_spec.extra
-                    == packet->data.ncasm_ret_param.inquired_type;
-
-        case MDR_PACKET_NCASM_SET_PARAM:
-            return reply_spec.extra
-                    == packet->data.ncasm_set_param.inquired_type;
-
-        case MDR_PACKET_NCASM_NTFY_PARAM:
-            return reply_spec.extra
-                    == packet->data.ncasm_ntfy_param.inquired_type;
+        errno = EINVAL;
+        return -1;
+    }
 
-        case MDR_PACKET_PLAY_GET_PARAM:
-            return true;
+    conn->request_priority = priority;
+    return 0;
+}
 
-        case MDR_PACKET_PLAY_RET_PARAM:
-            return reply_spec.extra
-                    == packet->data.play_ret_param.detailed_data_type;
+int mdr_packetconn_set_timeouts(mdr_packetconn_t* conn,
+                                int ack_timeout,
+                                int reply_timeout)
+{
+    if (ack_timeout < 0 || reply_timeout < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
 
-        case MDR_PACKET_PLAY_SET_PARAM:
-            return reply_spec.extra
-                    == packet->data.play_set_param.detailed_data_type;
+    conn->ack_rtt.fixed = ack_timeout * 1000000LL;
+    conn->reply_rtt.fixed = reply_timeout * 1000000LL;
+    return 0;
+}
 
-        case MDR_PACKET_PLAY_NTFY_PARAM:
-            return reply_spec.extra
-                    == packet->data.play_ntfy_param.detailed_data_type;
+int mdr_packetconn_set_max_tries(mdr_packetconn_t* conn, int tries)
+{
+    if (tries < 1 || tries > PACKET_MAX_TRIES)
+    {
+        errno = EINVAL;
+        return -1;
+    }
 
-        case MDR_PACKET_SYSTEM_GET_CAPABILITY:
-            return true;
+    conn->max_tries = tries;
+    return 0;
+}
 
-        case MDR_PACKET_SYSTEM_RET_CAPABILITY:
-            return reply_spec.extra
-                    == packet->data.system_ret_capability.inquired_type;
+int mdr_packetconn_process(mdr_packetconn_t* conn)
+{
+    return mdr_packetconn_process_by_availability(conn, true, true);
+}
 
-        case MDR_PACKET_SYSTEM_GET_PARAM:
-            return true;
+/*
+ * Get the bucket of subscriptions to packets of `type` with `extra`.
+ */
+static subscription_bucket_t* subscription_bucket(mdr_packetconn_t* conn,
+                                                  mdr_packet_type_t type,
+                                                  uint8_t extra)
+{
+    unsigned int hash = (unsigned int) type * 31 + extra;
+    return &conn->subscriptions[hash & (PACKET_SUBSCRIPTION_BUCKETS - 1)];
+}
 
-        case MDR_PACKET_SYSTEM_RET_PARAM:
-            return reply_spec.extra
-                    == packet->data.system_ret_param.inquired_type;
+/*
+ * Check if a received frame holds a packet matching a reply specifier
+ * without decoding it.
+ */
+static bool frame_matches(
+    mdr_packetconn_reply_specifier_t reply_spec,
+    mdr_frame_t* frame)
+{
+    return mdr_packet_frame_matches(frame,
+                                    reply_spec.packet_type,
+                                    reply_spec.extra);
+}
 
-        case MDR_PACKET_SYSTEM_SET_PARAM:
-            return reply_spec.extra
-                    == packet->data.system_set_param.inquired_type;
+/*
+ * Set the sequence id of a request, patching its wire bytes
+ * if it owns them.
+ */
+static void request_set_sequence_id(request_t* request, uint8_t sequence_id)
+{
+    if (request->owns_wire)
+    {
+        request->wire_len = mdr_packet_wire_set_sequence_id(
+                request->wire,
+                request->wire_len,
+                sequence_id);
+    }
+    request->sequence_id = sequence_id;
+}
 
-        case MDR_PACKET_SYSTEM_NTFY_PARAM:
-            return reply_spec.extra
-                    == packet->data.system_ntfy_param.inquired_type;
+/*
+ * Queue a request to be sent, patching the sequence id of a copy of
+ * the frame if it's shared with a template.
+ *
+ * Returns 0 on success, returns -1 and sets errno on error.
+ */
+static int queue_request(mdr_packetconn_t* conn, request_t* request)
+{
+    if (request->owns_wire || request->sequence_id == 0)
+    {
+        return mdr_frameconn_queue_escaped(conn->fconn,
+                                           request->wire,
+                                           request->wire_len);
     }
 
-    return false;
+    uint8_t wire[PACKET_TEMPLATE_MAX_LEN + 1];
+    memcpy(wire, request->wire, request->wire_len);
+    size_t wire_len = mdr_packet_wire_set_sequence_id(wire,
+                                                      request->wire_len,
+                                                      request->sequence_id);
+
+    return mdr_frameconn_queue_escaped(conn->fconn, wire, wire_len);
 }
 
 /*
@@ -356,53 +696,382 @@ static void advance_frame_queue(mdr_packetconn_t* conn)
     if (conn->request == NULL)
         return;
 
-    free(conn->request->frame);
-    request_t* next = conn->request->next;
-
-    free(conn->request);
-
-    conn->request = next;
-
-    if (conn->request == NULL)
-    {
-        conn->request_queue_tail = NULL;
-    }
-    else
+    if (conn->request->owns_wire)
     {
-        conn->request->frame->sequence_id = conn->next_sequence_id;
-        *mdr_frame_checksum(conn->request->frame)
-                = mdr_frame_compute_checksum(conn->request->frame);
-        conn->next_sequence_id = !conn->next_sequence_id;
+        free(conn->request->wire);
     }
-}
+    free(conn->request);
 
-int mdr_packetconn_process_by_availability(mdr_packetconn_t* conn,
-                                            bool readable,
-                                            bool writable)
-{
-    struct timespec now;
-    clock_gettime(CLOCK_MONOTONIC, &now);
+    conn->request = NULL;
 
-    if (writable)
+    for (int priority = 0; priority < PACKET_NUM_PRIORITIES; priority++)
     {
-        if (mdr_frameconn_flush_write(conn->fconn) < 0)
+        request_queue_t* queue = &conn->request_queues[priority];
+        if (queue->head != NULL)
         {
-            if (!(errno == EAGAIN || errno == EWOULDBLOCK))
+            conn->request = queue->head;
+            queue->head = queue->head->next;
+            if (queue->head == NULL)
             {
-                return -1;
+                queue->tail = NULL;
             }
+            conn->request->next = NULL;
+            break;
         }
     }
 
     if (conn->request != NULL)
     {
-        if (conn->request->attempts == 0)
+        request_set_sequence_id(conn->request, conn->next_sequence_id);
+        conn->next_sequence_id = !conn->next_sequence_id;
+    }
+}
+
+/*
+ * Call the result callback of a request, passing `packet` or,
+ * for raw requests, `payload`.
+ */
+static void call_result(callbacks_t* callbacks,
+                        mdr_packet_t* packet,
+                        const uint8_t* payload,
+                        size_t length)
+{
+    if (callbacks->raw)
+    {
+        if (callbacks->raw_result != NULL)
+        {
+            callbacks->raw_result(payload, length, callbacks->user_data);
+        }
+    }
+    else if (callbacks->result != NULL)
+    {
+        callbacks->result(packet, callbacks->user_data);
+    }
+}
+
+/*
+ * Dequeue the current request and call the result callbacks of it and
+ * every request coalesced with it.
+ */
+static void complete_request(mdr_packetconn_t* conn,
+                             mdr_packet_t* packet,
+                             const uint8_t* payload,
+                             size_t length)
+{
+    callbacks_t callbacks = conn->request->callbacks;
+    waiter_t* waiter = conn->request->waiters;
+
+    advance_frame_queue(conn);
+
+    call_result(&callbacks, packet, payload, length);
+
+    while (waiter != NULL)
+    {
+        waiter_t* next = waiter->next;
+        call_result(&waiter->callbacks, packet, payload, length);
+        free(waiter);
+        waiter = next;
+    }
+}
+
+/*
+ * Dequeue the current request and call the error callbacks of it and
+ * every request coalesced with it with errno set to `error`.
+ */
+static void fail_request(mdr_packetconn_t* conn, int error)
+{
+    callbacks_t callbacks = conn->request->callbacks;
+    waiter_t* waiter = conn->request->waiters;
+
+    advance_frame_queue(conn);
+
+    if (callbacks.error != NULL)
+    {
+        errno = error;
+        callbacks.error(callbacks.user_data);
+    }
+
+    while (waiter != NULL)
+    {
+        waiter_t* next = waiter->next;
+        if (waiter->callbacks.error != NULL)
+        {
+            errno = error;
+            waiter->callbacks.error(waiter->callbacks.user_data);
+        }
+        free(waiter);
+        waiter = next;
+    }
+}
+
+/*
+ * Handle a single received frame, ACKing it and dispatching the packet
+ * it contains to the current request or any matching subscriptions.
+ *
+ * The frame is freed.
+ *
+ * Returns 0 on success, returns -1 and sets errno on error.
+ */
+static int handle_frame(mdr_packetconn_t* conn,
+                        mdr_frame_t* frame,
+                        struct timespec now)
+{
+    if (frame->data_type == MDR_FRAME_DATA_TYPE_ACK)
+    {
+        if (conn->request != NULL
+                && !conn->request->acked
+                && frame->sequence_id
+                    == 1-conn->request->sequence_id)
+        {
+            // An ACK after a re-send could be for any of the sends,
+            // only unambiguous round trips are measured (Karn).
+            if (conn->request->attempts == 1)
+            {
+                rtt_estimator_sample(&conn->ack_rtt,
+                                     conn->request->timestamp,
+                                     now);
+            }
+
+            if (conn->request->expected_reply.only_ack)
+            {
+                complete_request(conn, NULL, NULL, 0);
+            }
+            else
+            {
+                conn->request->acked = true;
+                conn->request->timestamp = now;
+                conn->request->timeout = timespec_add(
+                        now, rtt_estimator_timeout(&conn->reply_rtt, 1));
+            }
+
+            mdr_frame_pool_release(conn->frame_pool, frame);
+        }
+        else
+        {
+#ifdef __DEBUG
+            printf("Unexpected ACK (seq ID %d)\n", frame->sequence_id);
+            if (conn->request != NULL)
+            {
+                printf("Current request has seq ID %d (type 0x%02x)\n",
+                       conn->request->sequence_id,
+                       conn->request->packet_type);
+            }
+            else
+            {
+                printf("No Current request\n");
+            }
+#endif
+            // Unexpected ACK
+            mdr_frame_pool_release(conn->frame_pool, frame);
+        }
+    }
+    else if (frame->data_type == MDR_FRAME_DATA_TYPE_DATA_MDR)
+    {
+        mdr_frame_t ack_frame;
+        ack_frame.data_type = MDR_FRAME_DATA_TYPE_ACK;
+        ack_frame.sequence_id = !frame->sequence_id;
+        ack_frame.payload_length = 0;
+        *mdr_frame_checksum(&ack_frame)
+                = mdr_frame_compute_checksum(&ack_frame);
+        
+        mdr_frameconn_queue_frame(conn->fconn, &ack_frame);
+        // Ignore queue error, if the ACK is never sent the device
+        // will send the frame again and it'll be ACK'd then.
+
+        // Only the header bytes are looked at to find out if anyone
+        // wants the packet, packets nobody wants are never decoded.
+        // Packets only wanted raw aren't decoded either.
+        bool request_matched = conn->request != NULL
+                && frame_matches(conn->request->expected_reply, frame);
+        bool subscription_matched = false;
+        mdr_packet_type_t type;
+        uint8_t extra;
+        subscription_bucket_t* bucket = NULL;
+        bool decode = request_matched && !conn->request->callbacks.raw;
+
+        if (request_matched && conn->request->acked
+                && conn->request->attempts == 1)
+        {
+            rtt_estimator_sample(&conn->reply_rtt,
+                                 conn->request->timestamp,
+                                 now);
+        }
+
+        if (!request_matched && mdr_packet_frame_peek(frame, &type, &extra))
+        {
+            bucket = subscription_bucket(conn, type, extra);
+            for (subscription_t* subscription = bucket->head;
+                 subscription != NULL;
+                 subscription = subscription->next)
+            {
+                if (subscription->specifier.packet_type == type
+                        && subscription->specifier.extra == extra)
+                {
+                    subscription_matched = true;
+                    if (!subscription->callbacks.raw)
+                    {
+                        decode = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (!request_matched && !subscription_matched)
+        {
+#ifdef __DEBUG
+            if (frame->payload_length > 0)
+            {
+                printf("Got unexpected packet (type %02x)\n",
+                       mdr_frame_payload(frame)[0]);
+            }
+            if (conn->request != NULL)
+            {
+                printf("Expected %02x (%02x)\n",
+                       conn->request->expected_reply.packet_type,
+                       conn->request->expected_reply.extra);
+            }
+            else
+            {
+                printf("No Current request\n");
+            }
+#endif
+
+            mdr_frame_pool_release(conn->frame_pool, frame);
+            return 0;
+        }
+
+        const uint8_t* payload = mdr_frame_payload(frame);
+        size_t payload_length = frame->payload_length;
+
+        if (request_matched && conn->request->callbacks.raw)
+        {
+            complete_request(conn, NULL, payload, payload_length);
+
+            mdr_frame_pool_release(conn->frame_pool, frame);
+            return 0;
+        }
+
+        if (subscription_matched)
+        {
+            subscription_t* next = NULL;
+            for (subscription_t* subscription = bucket->head;
+                 subscription != NULL;
+                 subscription = next)
+            {
+                next = subscription->next;
+                if (subscription->callbacks.raw
+                        && subscription->callbacks.raw_result != NULL
+                        && subscription->specifier.packet_type == type
+                        && subscription->specifier.extra == extra)
+                {
+                    subscription->callbacks.raw_result(
+                            payload,
+                            payload_length,
+                            subscription->callbacks.user_data);
+                }
+            }
+        }
+
+        if (!decode)
+        {
+            mdr_frame_pool_release(conn->frame_pool, frame);
+            return 0;
+        }
+
+        // Packets are only handed to callbacks, decode a view borrowing
+        // the strings of the frame and only allocate if it doesn't fit.
+        union
+        {
+            max_align_t align;
+            uint8_t bytes[PACKET_VIEW_SIZE];
+        }
+        view;
+        bool owned = false;
+
+        mdr_packet_t* packet = mdr_packet_view_from_frame(
+                frame, view.bytes, PACKET_VIEW_SIZE);
+        if (packet == NULL && errno == ENOBUFS)
+        {
+            packet = mdr_packet_from_frame(frame);
+            owned = true;
+        }
+
+        if (packet == NULL)
+        {
+#ifdef __DEBUG
+            printf("Failed to parse packet from frame: %d", errno);
+            if (frame->payload_length > 0)
+            {
+                printf(" (id 0x%02x)\n", mdr_frame_payload(frame)[0]);
+            }
+            else
+            {
+                printf(" (empty)\n");
+            }
+#endif
+
+            // The packet has been ACK'd already, a packet which can't
+            // be decoded is dropped without failing the connection.
+            mdr_frame_pool_release(conn->frame_pool, frame);
+            return 0;
+        }
+
+        if (request_matched)
+        {
+            complete_request(conn, packet, payload, payload_length);
+        }
+        else
+        {
+            subscription_t* next = NULL;
+            for (subscription_t* subscription = bucket->head;
+                 subscription != NULL;
+                 subscription = next)
+            {
+                next = subscription->next;
+                if (!subscription->callbacks.raw
+                        && subscription->specifier.packet_type == type
+                        && subscription->specifier.extra == extra)
+                {
+                    if (subscription->callbacks.result != NULL)
+                    {
+                        subscription->callbacks.result(
+                                packet,
+                                subscription->callbacks.user_data);
+                    }
+                }
+            }
+        }
+
+        if (owned)
+        {
+            mdr_packet_free(packet);
+        }
+        mdr_frame_pool_release(conn->frame_pool, frame);
+    }
+    else
+    {
+        // Unknown/unsupported data type
+        mdr_frame_pool_release(conn->frame_pool, frame);
+    }
+
+    return 0;
+}
+
+int mdr_packetconn_process_by_availability(mdr_packetconn_t* conn,
+                                            bool readable,
+                                            bool writable)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (conn->request != NULL)
+    {
+        if (conn->request->attempts == 0)
         {
             if (writable)
             {
-                if (mdr_frameconn_write_frame(
-                            conn->fconn,
-                            conn->request->frame) < 0)
+                if (queue_request(conn, conn->request) < 0)
                 {
                     if (!(errno == EAGAIN || errno == EWOULDBLOCK))
                     {
@@ -412,39 +1081,31 @@ int mdr_packetconn_process_by_availability(mdr_packetconn_t* conn,
                 else
                 {
                     conn->request->attempts++;
-                    conn->request->timeout
-                            = timespec_add(now, packet_ack_timeout);
+                    conn->request->timestamp = now;
+                    conn->request->timeout = timespec_add(
+                            now,
+                            rtt_estimator_timeout(&conn->ack_rtt,
+                                                  conn->request->attempts));
                 }
             }
         }
         else if (timespec_compare(now, conn->request->timeout) > 0)
         {
             if (conn->request->acked
-                    || conn->request->attempts >= PACKET_MAX_TRIES)
+                    || conn->request->attempts >= conn->max_tries)
             {
-                mdr_packetconn_error_callback error_callback
-                        = conn->request->callbacks.error;
-                void* user_data = conn->request->callbacks.user_data;
+                int error = conn->request->acked
+                        ? MDR_E_NO_REPLY
+                        : MDR_E_NO_ACK;
 
                 if (!conn->request->acked)
                     conn->next_sequence_id = !conn->next_sequence_id;
 
-                if (error_callback != NULL)
-                {
-                    if (conn->request->acked)
-                        errno = MDR_E_NO_REPLY;
-                    else
-                        errno = MDR_E_NO_ACK;
-                    error_callback(user_data);
-                }
-
-                advance_frame_queue(conn);
+                fail_request(conn, error);
             }
             else
             {
-                if (mdr_frameconn_write_frame(
-                            conn->fconn,
-                            conn->request->frame) < 0)
+                if (queue_request(conn, conn->request) < 0)
                 {
                     if (!(errno == EAGAIN || errno == EWOULDBLOCK))
                     {
@@ -454,186 +1115,265 @@ int mdr_packetconn_process_by_availability(mdr_packetconn_t* conn,
                 else
                 {
                     conn->request->attempts++;
-                    conn->request->timeout
-                            = timespec_add(now, packet_ack_timeout);
+                    conn->request->timestamp = now;
+                    conn->request->timeout = timespec_add(
+                            now,
+                            rtt_estimator_timeout(&conn->ack_rtt,
+                                                  conn->request->attempts));
                 }
             }
         }
     }
 
-    if (readable)
-    {
-        mdr_frame_t* frame = mdr_frameconn_read_frame(conn->fconn);
+    bool active = conn->request != NULL;
 
-        if (frame == NULL)
+    // Frames left over by the frame budget are handled even if the socket
+    // isn't readable, it won't become readable for them.
+    if (readable || mdr_frameconn_waiting_read(conn->fconn))
+    {
+        mdr_frame_t* frames[PACKET_MAX_FRAME_BUDGET];
+        int count = readable
+                ? mdr_frameconn_read_frames(conn->fconn,
+                                            frames,
+                                            conn->frame_budget)
+                : mdr_frameconn_read_buffered_frames(conn->fconn,
+                                                     frames,
+                                                     conn->frame_budget);
+
+        if (count < 0)
         {
-            if (!(errno = EAGAIN || errno == EWOULDBLOCK))
+            if (!(errno == EAGAIN || errno == EWOULDBLOCK))
             {
                 return -1;
             }
         }
-        else
-        {
-            if (frame->data_type == MDR_FRAME_DATA_TYPE_ACK)
-            {
-                if (conn->request != NULL
-                        && !conn->request->acked
-                        && frame->sequence_id
-                            == 1-conn->request->frame->sequence_id)
-                {
-                    if (conn->request->expected_reply.only_ack)
-                    {
-                        mdr_packetconn_result_callback result_callback
-                                = conn->request->callbacks.result;
-                        void* user_data = conn->request->callbacks.user_data;
-
-                        advance_frame_queue(conn);
 
-                        if (result_callback != NULL)
-                        {
-                            result_callback(NULL, user_data);
-                        }
-                    }
-                    else
-                    {
-                        conn->request->acked = true;
-                        conn->request->timeout
-                                = timespec_add(now, packet_reply_timeout);
-                    }
+        if (count > 0)
+        {
+            active = true;
+        }
 
-                    free(frame);
-                }
-                else
+        for (int i = 0; i < count; i++)
+        {
+            if (handle_frame(conn, frames[i], now) < 0)
+            {
+                for (i++; i < count; i++)
                 {
-#ifdef __DEBUG
-                    printf("Unexpected ACK (seq ID %d)\n", frame->sequence_id);
-                    if (conn->request != NULL)
-                    {
-                        printf("Current request has seq ID %d",
-                               conn->request->frame->sequence_id);
-                        if (conn->request->frame->payload_length > 0)
-                        {
-
-                            printf(" (type 0x%02x)\n",
-                                   mdr_frame_payload(conn->request->frame)[0]);
-                        }
-                        else
-                        {
-                            printf(" (invalid)\n");
-                        }
-                    }
-                    else
-                    {
-                        printf("No Current request\n");
-                    }
-#endif
-                    // Unexpected ACK
-                    free(frame);
+                    mdr_frame_pool_release(conn->frame_pool, frames[i]);
                 }
+                return -1;
             }
-            else if (frame->data_type == MDR_FRAME_DATA_TYPE_DATA_MDR)
+        }
+    }
+
+    // Everything queued this turn, ACKs and requests alike,
+    // goes out in a single write.
+    if (mdr_frameconn_waiting_write(conn->fconn))
+    {
+        if (mdr_frameconn_flush_write(conn->fconn) < 0)
+        {
+            if (!(errno == EAGAIN || errno == EWOULDBLOCK))
             {
-                mdr_frame_t ack_frame;
-                ack_frame.data_type = MDR_FRAME_DATA_TYPE_ACK;
-                ack_frame.sequence_id = !frame->sequence_id;
-                ack_frame.payload_length = 0;
-                *mdr_frame_checksum(&ack_frame)
-                        = mdr_frame_compute_checksum(&ack_frame);
-                
-                mdr_frameconn_write_frame(conn->fconn, &ack_frame);
-                // Ignore send error, if the send fails the device will send it
-                // again and it'll be ACK'd then.
-
-                mdr_packet_t* packet = mdr_packet_from_frame(frame);
-                if (packet == NULL)
-                {
-#ifdef __DEBUG
-                    printf("Failed to parse packet from frame: %d", errno);
-                    if (frame->payload_length > 0)
-                    {
-                        printf(" (id 0x%02x)\n", mdr_frame_payload(frame)[0]);
-                    }
-                    else
-                    {
-                        printf(" (empty)\n");
-                    }
-#endif
+                return -1;
+            }
+        }
+    }
 
-                    free(frame);
-                    return -1;
-                }
+    // Give the I/O buffers back once the connection has been idle
+    // for a while.
+    if (active)
+    {
+        conn->buffer_release_time
+                = timespec_add(now, packet_buffer_idle_timeout);
+    }
+    else if (mdr_frameconn_has_buffers(conn->fconn)
+            && timespec_compare(now, conn->buffer_release_time) > 0)
+    {
+        mdr_frameconn_release_buffers(conn->fconn);
+    }
 
-                free(frame);
+    return 0;
+}
 
-                if (conn->request != NULL
-                        && reply_specifier_matches(
-                            conn->request->expected_reply, packet))
-                {
-                    mdr_packetconn_result_callback result_callback
-                            = conn->request->callbacks.result;
-                    void* user_data = conn->request->callbacks.user_data;
+/*
+ * Check if a queued request is a GET identical to the one encoded as
+ * `wire` with sequence id 0, expecting the same reply.
+ */
+static bool request_is_identical_get(
+        request_t* request,
+        mdr_packet_type_t packet_type,
+        const uint8_t* wire,
+        size_t wire_len,
+        mdr_packetconn_reply_specifier_t reply_spec,
+        bool raw)
+{
+    if (request->packet_type != packet_type
+            || request->callbacks.raw != raw
+            || request->expected_reply.only_ack
+            || request->expected_reply.packet_type != reply_spec.packet_type
+            || request->expected_reply.extra != reply_spec.extra)
+    {
+        return false;
+    }
 
-                    advance_frame_queue(conn);
+    // Unless it's shared with a template, the frame of a queued request
+    // has its sequence id patched in already.
+    if (!request->owns_wire || request->sequence_id == 0)
+    {
+        return request->wire_len == wire_len
+            && memcmp(request->wire, wire, wire_len) == 0;
+    }
 
-                    if (result_callback != NULL)
-                    {
-                        result_callback(packet, user_data);
-                    }
-                }
-                else
-                {
-#ifdef __DEBUG
-                    bool subscription_matched = false;
-#endif
-                    for (subscription_t* subscription = conn->subscription;
-                         subscription != NULL;
-                         subscription = subscription->next)
-                    {
-                        if (reply_specifier_matches(
-                                subscription->specifier, packet))
-                        {
-#ifdef __DEBUG
-                            subscription_matched = true;
-#endif
-                            if (subscription->callbacks.result != NULL)
-                            {
-                                subscription->callbacks.result(
-                                        packet,
-                                        subscription->callbacks.user_data);
-                            }
-                        }
-                    }
+    if (wire_len > PACKET_TEMPLATE_MAX_LEN)
+    {
+        return false;
+    }
 
-#ifdef __DEBUG
-                    if (!subscription_matched)
-                    {
-                        printf("Got unexpected packet (type %02x)\n",
-                               packet->type);
-                        if (conn->request != NULL)
-                        {
-                            printf("Expected %02x (%02x)\n",
-                                   conn->request->expected_reply.packet_type,
-                                   conn->request->expected_reply.extra);
-                        }
-                        else
-                        {
-                            printf("No Current request\n");
-                        }
-                    }
-#endif
-                }
+    uint8_t patched[PACKET_TEMPLATE_MAX_LEN + 1];
+    memcpy(patched, wire, wire_len);
+    size_t patched_len = mdr_packet_wire_set_sequence_id(patched,
+                                                         wire_len,
+                                                         1);
 
-                mdr_packet_free(packet);
-            }
-            else
-            {
-                // Unknown/unsupported data type
-                free(frame);
-            }
+    return request->wire_len == patched_len
+        && memcmp(request->wire, patched, patched_len) == 0;
+}
+
+/*
+ * Coalesce a GET request with an identical request already in the queue,
+ * so a single request is sent and its reply passed to both.
+ *
+ * Returns the handle of the queued request, or NULL if there is none
+ * or the request isn't a GET.
+ */
+static void* coalesce_request(mdr_packetconn_t* conn,
+                              mdr_packet_type_t packet_type,
+                              const uint8_t* wire,
+                              size_t wire_len,
+                              mdr_packetconn_reply_specifier_t reply_spec,
+                              callbacks_t callbacks)
+{
+    if (reply_spec.only_ack || !mdr_packet_type_is_get(packet_type))
+    {
+        return NULL;
+    }
+
+    for (request_t* request = conn->request;
+         request != NULL;
+         request = request_after(conn, request))
+    {
+        if (!request_is_identical_get(request,
+                                      packet_type,
+                                      wire,
+                                      wire_len,
+                                      reply_spec,
+                                      callbacks.raw))
+        {
+            continue;
         }
+
+        waiter_t* waiter = malloc(sizeof(waiter_t));
+        if (waiter == NULL) return NULL;
+
+        waiter->callbacks = callbacks;
+        waiter->next = NULL;
+
+        waiter_t** tail = &request->waiters;
+        while (*tail != NULL) tail = &(*tail)->next;
+        *tail = waiter;
+
+        raise_priority(conn, request, conn->request_priority);
+
+        return request;
     }
 
-    return 0;
+    return NULL;
+}
+
+/*
+ * Replace a queued SET request for the same setting as `request` which
+ * hasn't been sent yet with it, keeping its place in the queue unless its
+ * priority is raised. The replaced request fails with MDR_E_SUPERSEDED.
+ *
+ * `request` isn't queued itself, its frame is taken over on success.
+ *
+ * Returns the handle of the replaced request, or NULL if there is none.
+ */
+static void* supersede_request(mdr_packetconn_t* conn,
+                               request_t* request,
+                               mdr_packetconn_reply_specifier_t reply_spec,
+                               callbacks_t callbacks)
+{
+    for (request_t* queued = conn->request;
+         queued != NULL;
+         queued = request_after(conn, queued))
+    {
+        if (!queued->supersedable
+                || queued->attempts > 0
+                || queued->packet_type != request->packet_type
+                || queued->extra != request->extra)
+        {
+            continue;
+        }
+
+        callbacks_t superseded = queued->callbacks;
+
+        free(queued->wire);
+        queued->wire = request->wire;
+        queued->wire_len = request->wire_len;
+        request_set_sequence_id(queued, queued->sequence_id);
+
+        queued->callbacks = callbacks;
+        queued->expected_reply = reply_spec;
+
+        raise_priority(conn, queued, conn->request_priority);
+
+        if (superseded.error != NULL)
+        {
+            errno = MDR_E_SUPERSEDED;
+            superseded.error(superseded.user_data);
+        }
+
+        return queued;
+    }
+
+    return NULL;
+}
+
+/*
+ * Fill in the callbacks of a request and add it to the queue.
+ */
+static void enqueue_request(mdr_packetconn_t* conn,
+                            request_t* request,
+                            mdr_packetconn_reply_specifier_t reply_spec,
+                            mdr_packetconn_result_callback result_callback,
+                            mdr_packetconn_error_callback error_callback,
+                            void* user_data)
+{
+    request->sequence_id = 0;
+    request->attempts = 0;
+    request->acked = false;
+    request->callbacks.raw = false;
+    request->callbacks.result = result_callback;
+    request->callbacks.raw_result = NULL;
+    request->callbacks.error = error_callback;
+    request->callbacks.user_data = user_data;
+    request->expected_reply = reply_spec;
+    request->waiters = NULL;
+    request->priority = conn->request_priority;
+    request->next = NULL;
+
+    if (conn->request == NULL)
+    {
+        conn->request = request;
+
+        request_set_sequence_id(request, conn->next_sequence_id);
+        conn->next_sequence_id = !conn->next_sequence_id;
+    }
+    else
+    {
+        append_request(conn, request);
+    }
 }
 
 void* mdr_packetconn_make_request(
@@ -644,68 +1384,306 @@ void* mdr_packetconn_make_request(
         mdr_packetconn_error_callback error_callback,
         void* user_data)
 {
-    mdr_frame_t* frame = mdr_packet_to_frame(packet);
-    if (frame == NULL) return NULL;
+    size_t length = mdr_packet_encoded_size(packet);
+    if (length == 0) return NULL;
 
     request_t* request = malloc(sizeof(request_t));
-    if (request == NULL)
+    if (request == NULL) return NULL;
+
+    // Encode into a buffer large enough for any escaping, then keep only
+    // what's used plus the byte a sequence id change may need.
+    size_t size = MDR_PACKET_WIRE_MAX_LEN(length);
+    request->wire = malloc(size);
+    if (request->wire == NULL)
     {
-        free(frame);
+        free(request);
         return NULL;
     }
 
-    request->frame = frame;
-    request->attempts = 0;
-    request->acked = false;
-    request->callbacks.result = result_callback;
-    request->callbacks.error = error_callback;
-    request->callbacks.user_data = user_data;
-    request->expected_reply = reply_spec;
-    request->next = NULL;
+    request->wire_len = mdr_packet_encode_wire(packet,
+                                               0,
+                                               request->wire,
+                                               size);
+    if (request->wire_len == 0)
+    {
+        free(request->wire);
+        free(request);
+        return NULL;
+    }
 
-    if (conn->request == NULL)
+    callbacks_t callbacks = {
+        .raw = false,
+        .result = result_callback,
+        .error = error_callback,
+        .user_data = user_data,
+    };
+
+    void* handle = coalesce_request(conn,
+                                    packet->type,
+                                    request->wire,
+                                    request->wire_len,
+                                    reply_spec,
+                                    callbacks);
+    if (handle != NULL)
+    {
+        free(request->wire);
+        free(request);
+        return handle;
+    }
+
+    uint8_t* wire = realloc(request->wire, request->wire_len + 1);
+    if (wire != NULL)
     {
-        conn->request = conn->request_queue_tail = request;
+        request->wire = wire;
+    }
 
-        request->frame->sequence_id = conn->next_sequence_id;
-        *mdr_frame_checksum(request->frame)
-                = mdr_frame_compute_checksum(request->frame);
-        conn->next_sequence_id = !conn->next_sequence_id;
-        
-        return request;
-    } else {
-        conn->request_queue_tail->next = request;
-        conn->request_queue_tail = request;
+    request->owns_wire = true;
+    request->packet_type = packet->type;
+    request->supersedable = mdr_packet_type_is_set(packet->type);
+    request->extra = mdr_packet_extra(packet);
 
-        return request;
+    if (request->supersedable)
+    {
+        handle = supersede_request(conn, request, reply_spec, callbacks);
+        if (handle != NULL)
+        {
+            free(request);
+            return handle;
+        }
     }
+
+    enqueue_request(conn,
+                    request,
+                    reply_spec,
+                    result_callback,
+                    error_callback,
+                    user_data);
+
+    return request;
 }
 
-void* mdr_packetconn_subscribe(
+void* mdr_packetconn_make_raw_request(
         mdr_packetconn_t* conn,
+        const uint8_t* payload,
+        size_t length,
         mdr_packetconn_reply_specifier_t reply_spec,
-        mdr_packetconn_result_callback callback,
+        mdr_packetconn_raw_result_callback result_callback,
+        mdr_packetconn_error_callback error_callback,
         void* user_data)
 {
-    subscription_t* subscription = malloc(sizeof(subscription_t));
-    if (subscription == NULL)
+    if (length == 0)
+    {
+        errno = EINVAL;
         return NULL;
+    }
+
+    request_t* request = malloc(sizeof(request_t));
+    if (request == NULL) return NULL;
+
+    size_t size = MDR_PACKET_WIRE_MAX_LEN(length);
+    request->wire = malloc(size);
+    if (request->wire == NULL)
+    {
+        free(request);
+        return NULL;
+    }
+
+    request->wire_len = mdr_packet_encode_wire_payload(payload,
+                                                       length,
+                                                       0,
+                                                       request->wire,
+                                                       size);
+    if (request->wire_len == 0)
+    {
+        free(request->wire);
+        free(request);
+        return NULL;
+    }
+
+    void* handle = coalesce_request(
+            conn,
+            payload[0],
+            request->wire,
+            request->wire_len,
+            reply_spec,
+            (callbacks_t){
+                .raw = true,
+                .raw_result = result_callback,
+                .error = error_callback,
+                .user_data = user_data,
+            });
+    if (handle != NULL)
+    {
+        free(request->wire);
+        free(request);
+        return handle;
+    }
+
+    uint8_t* wire = realloc(request->wire, request->wire_len + 1);
+    if (wire != NULL)
+    {
+        request->wire = wire;
+    }
+
+    request->owns_wire = true;
+    request->packet_type = payload[0];
+    request->supersedable = false;
+    request->extra = 0;
+
+    enqueue_request(conn,
+                    request,
+                    reply_spec,
+                    NULL,
+                    error_callback,
+                    user_data);
+    request->callbacks.raw = true;
+    request->callbacks.raw_result = result_callback;
+
+    return request;
+}
+
+mdr_packetconn_template_t* mdr_packetconn_template_new(mdr_packet_t* packet)
+{
+    mdr_packetconn_template_t* template
+            = malloc(sizeof(mdr_packetconn_template_t));
+    if (template == NULL) return NULL;
+
+    template->packet_type = packet->type;
+    template->wire_len = mdr_packet_encode_wire(packet,
+                                                0,
+                                                template->wire,
+                                                PACKET_TEMPLATE_MAX_LEN);
+    if (template->wire_len == 0)
+    {
+        free(template);
+        return NULL;
+    }
+
+    return template;
+}
+
+void mdr_packetconn_template_free(mdr_packetconn_template_t* template)
+{
+    free(template);
+}
+
+void* mdr_packetconn_make_request_from_template(
+        mdr_packetconn_t* conn,
+        const mdr_packetconn_template_t* template,
+        mdr_packetconn_reply_specifier_t reply_spec,
+        mdr_packetconn_result_callback result_callback,
+        mdr_packetconn_error_callback error_callback,
+        void* user_data)
+{
+    void* handle = coalesce_request(
+            conn,
+            template->packet_type,
+            template->wire,
+            template->wire_len,
+            reply_spec,
+            (callbacks_t){
+                .raw = false,
+                .result = result_callback,
+                .error = error_callback,
+                .user_data = user_data,
+            });
+    if (handle != NULL)
+    {
+        return handle;
+    }
+
+    request_t* request = malloc(sizeof(request_t));
+    if (request == NULL) return NULL;
+
+    // The frame is never written through a request which doesn't own it.
+    request->wire = (uint8_t*) template->wire;
+    request->wire_len = template->wire_len;
+    request->owns_wire = false;
+    request->packet_type = template->packet_type;
+    request->supersedable = false;
+    request->extra = 0;
+
+    enqueue_request(conn,
+                    request,
+                    reply_spec,
+                    result_callback,
+                    error_callback,
+                    user_data);
+
+    return request;
+}
+
+/*
+ * Append a subscription to the bucket of the packets it matches.
+ */
+static void add_subscription(mdr_packetconn_t* conn,
+                             subscription_t* subscription,
+                             mdr_packetconn_reply_specifier_t reply_spec)
+{
+    // The extra parameter isn't checked for types without one,
+    // all such subscriptions go in the same bucket.
+    if (!mdr_packet_type_has_extra(reply_spec.packet_type))
+    {
+        reply_spec.extra = 0;
+    }
 
-    subscription->callbacks.result = callback;
-    subscription->callbacks.error = NULL;
-    subscription->callbacks.user_data = user_data;
     subscription->specifier = reply_spec;
+
+    subscription_bucket_t* bucket = subscription_bucket(
+            conn, reply_spec.packet_type, reply_spec.extra);
+
+    subscription->prev = bucket->tail;
     subscription->next = NULL;
 
-    if (conn->subscription == NULL)
+    if (bucket->tail == NULL)
     {
-        conn->subscription = conn->subscription_list_tail = subscription;
+        bucket->head = subscription;
     }
     else
     {
-        conn->subscription_list_tail->next = subscription;
-        conn->subscription_list_tail = subscription;
+        bucket->tail->next = subscription;
     }
+    bucket->tail = subscription;
+}
+
+void* mdr_packetconn_subscribe(
+        mdr_packetconn_t* conn,
+        mdr_packetconn_reply_specifier_t reply_spec,
+        mdr_packetconn_result_callback callback,
+        void* user_data)
+{
+    subscription_t* subscription = malloc(sizeof(subscription_t));
+    if (subscription == NULL)
+        return NULL;
+
+    subscription->callbacks.raw = false;
+    subscription->callbacks.result = callback;
+    subscription->callbacks.raw_result = NULL;
+    subscription->callbacks.error = NULL;
+    subscription->callbacks.user_data = user_data;
+
+    add_subscription(conn, subscription, reply_spec);
+
+    return subscription;
+}
+
+void* mdr_packetconn_subscribe_raw(
+        mdr_packetconn_t* conn,
+        mdr_packetconn_reply_specifier_t reply_spec,
+        mdr_packetconn_raw_result_callback callback,
+        void* user_data)
+{
+    subscription_t* subscription = malloc(sizeof(subscription_t));
+    if (subscription == NULL)
+        return NULL;
+
+    subscription->callbacks.raw = true;
+    subscription->callbacks.result = NULL;
+    subscription->callbacks.raw_result = callback;
+    subscription->callbacks.error = NULL;
+    subscription->callbacks.user_data = user_data;
+
+    add_subscription(conn, subscription, reply_spec);
 
     return subscription;
 }
@@ -714,31 +1692,31 @@ void* mdr_packetconn_wait_for_result(mdr_packetconn_t* conn, void* handle);
 
 void mdr_packetconn_remove_subscription(mdr_packetconn_t* conn, void* handle)
 {
-    subscription_t* prev = NULL;
-    for (subscription_t* subscription = conn->subscription;
-         subscription != NULL;
-         prev = subscription, subscription = subscription->next)
-    {
-        if (subscription == handle)
-        {
-            if (subscription->next == NULL)
-            {
-                conn->subscription_list_tail = prev;
-            }
+    subscription_t* subscription = handle;
+    subscription_bucket_t* bucket = subscription_bucket(
+            conn,
+            subscription->specifier.packet_type,
+            subscription->specifier.extra);
 
-            if (prev != NULL)
-            {
-                prev->next = subscription->next;
-            }
-            else
-            {
-                conn->subscription = subscription->next;
-            }
+    if (subscription->prev != NULL)
+    {
+        subscription->prev->next = subscription->next;
+    }
+    else
+    {
+        bucket->head = subscription->next;
+    }
 
-            free(subscription);
-            break;
-        }
+    if (subscription->next != NULL)
+    {
+        subscription->next->prev = subscription->prev;
     }
+    else
+    {
+        bucket->tail = subscription->prev;
+    }
+
+    free(subscription);
 }
 
 static struct timespec timespec_add(struct timespec a, struct timespec b)
@@ -782,3 +1760,18 @@ static int timespec_compare(struct timespec a, struct timespec b)
     else if (a.tv_nsec > b.tv_nsec) return 1;
     else return 0;
 }
+
+static int64_t timespec_to_ns(struct timespec a)
+{
+    return (int64_t) a.tv_sec * 1000000000 + a.tv_nsec;
+}
+
+static struct timespec timespec_from_ns(int64_t ns)
+{
+    struct timespec result;
+
+    result.tv_sec = ns / 1000000000;
+    result.tv_nsec = ns % 1000000000;
+
+    return result;
+}
@@ -21,8 +21,23 @@
  */
 
 #include "mdr/packet.h"
+#include "mdr/packetconn.h"
+#include "mdr/frameconn.h"
+#include "mdr/transport.h"
+#include "mdr/uring.h"
+#include "mdr/errors.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
 
 #define ASSERT_SIZE(type, n) \
     if (sizeof(type) != n) { \
@@ -43,7 +58,925 @@
         } \
     }
 
-int main(int argc, char* argv[])
+#define ASSERT(cond) \
+    if (!(cond)) { \
+        printf("%s:%d: Expected " #cond ".\n", __FILE__, __LINE__); \
+        exit(1); \
+    }
+
+/*
+ * Number of times to retry an operation which would block
+ * before failing a test.
+ */
+#define MAX_ATTEMPTS 10000
+
+/*
+ * A frame whose two byte payload is `n`.
+ */
+static mdr_frame_t* new_test_frame(uint8_t sequence_id, uint16_t n)
+{
+    mdr_frame_t* frame = malloc(sizeof(mdr_frame_t) + 2);
+    ASSERT(frame != NULL);
+
+    frame->data_type = MDR_FRAME_DATA_TYPE_DATA_MDR;
+    frame->sequence_id = sequence_id;
+    frame->payload_length = 2;
+    mdr_frame_payload(frame)[0] = n >> 8;
+    mdr_frame_payload(frame)[1] = n & 0xff;
+    *mdr_frame_checksum(frame) = mdr_frame_compute_checksum(frame);
+
+    return frame;
+}
+
+static uint16_t test_frame_number(mdr_frame_t* frame)
+{
+    ASSERT(frame->payload_length == 2);
+    return mdr_frame_payload(frame)[0] << 8 | mdr_frame_payload(frame)[1];
+}
+
+/*
+ * Frames released to a pool are only reused for payloads they can hold,
+ * whatever their payload length says.
+ */
+static void test_frame_pool_release(void)
+{
+    mdr_frame_pool_t* pool = mdr_frame_pool_new();
+    ASSERT(pool != NULL);
+
+    // Reused for the same size class.
+    mdr_frame_t* frame = mdr_frame_pool_acquire(pool, 10);
+    ASSERT(frame != NULL);
+    mdr_frame_pool_release(pool, frame);
+    ASSERT(mdr_frame_pool_acquire(pool, 40) == frame);
+    mdr_frame_pool_release(pool, frame);
+
+    // A frame allocated for its exact size, between two size classes.
+    mdr_frame_t* exact = malloc(MDR_FRAME_EMPTY_LEN + 100);
+    ASSERT(exact != NULL);
+    exact->payload_length = 100;
+    mdr_frame_pool_release(pool, exact);
+
+    for (int i = 0; i < 8; i++)
+    {
+        frame = mdr_frame_pool_acquire(pool, 120);
+        ASSERT(frame != NULL && frame != exact);
+        memset(mdr_frame_payload(frame), 0, 121);
+        free(frame);
+    }
+
+    mdr_frame_pool_free(pool);
+}
+
+static void make_nonblocking(int fd)
+{
+    ASSERT(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == 0);
+}
+
+/*
+ * Submit and handle the operations of `ring`, if there is one,
+ * waiting a little for completions.
+ */
+static void pump_ring(mdr_uring_t* ring)
+{
+    if (ring == NULL) return;
+
+    struct pollfd pfd = { .fd = mdr_uring_get_fd(ring), .events = POLLIN };
+    poll(&pfd, 1, 1);
+    ASSERT(mdr_uring_submit(ring) == 0);
+}
+
+static void flush_write(mdr_frameconn_t* conn)
+{
+    if (mdr_frameconn_flush_write(conn) < 0)
+    {
+        ASSERT(errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+/*
+ * Write `count` frames to `from` and check they're read from `to` in order.
+ */
+static void check_frame_round_trip(mdr_frameconn_t* from,
+                                   mdr_frameconn_t* to,
+                                   mdr_uring_t* ring,
+                                   int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        mdr_frame_t* frame = new_test_frame(i & 1, i);
+        ASSERT(mdr_frameconn_write_frame(from, frame) == 0);
+        free(frame);
+    }
+
+    int received = 0;
+    for (int attempt = 0; attempt < MAX_ATTEMPTS && received < count; attempt++)
+    {
+        flush_write(from);
+        pump_ring(ring);
+
+        mdr_frame_t* frame;
+        while (received < count
+                && (frame = mdr_frameconn_read_frame(to)) != NULL)
+        {
+            ASSERT(frame->sequence_id == (received & 1));
+            ASSERT(test_frame_number(frame) == received);
+            free(frame);
+            received++;
+        }
+        if (received < count)
+        {
+            ASSERT(errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+
+    ASSERT(received == count);
+}
+
+static void test_frameconn_fd(void)
+{
+    mdr_transport_t* transports[2];
+    ASSERT(mdr_transport_new_socketpair(transports) == 0);
+
+    mdr_frameconn_t* a = mdr_frameconn_new_from_transport(transports[0]);
+    mdr_frameconn_t* b = mdr_frameconn_new_from_transport(transports[1]);
+    make_nonblocking(mdr_frameconn_get_socket(a));
+    make_nonblocking(mdr_frameconn_get_socket(b));
+
+    check_frame_round_trip(a, b, NULL, 400);
+    check_frame_round_trip(b, a, NULL, 400);
+
+    mdr_frameconn_close(a);
+    mdr_frameconn_close(b);
+}
+
+static void test_frameconn_loopback(void)
+{
+    mdr_transport_t* transports[2];
+    ASSERT(mdr_transport_new_loopback(transports) == 0);
+
+    mdr_frameconn_t* a = mdr_frameconn_new_from_transport(transports[0]);
+    mdr_frameconn_t* b = mdr_frameconn_new_from_transport(transports[1]);
+
+    check_frame_round_trip(a, b, NULL, 400);
+    check_frame_round_trip(b, a, NULL, 400);
+
+    mdr_frameconn_close(a);
+
+    // The remote end closing is seen once everything has been read.
+    ASSERT(mdr_frameconn_read_frame(b) == NULL);
+    ASSERT(errno == MDR_E_CLOSED);
+
+    mdr_frameconn_close(b);
+}
+
+/*
+ * Create a ring, or return NULL if io_uring isn't available.
+ */
+static mdr_uring_t* new_test_ring(unsigned int entries)
+{
+    mdr_uring_t* ring = mdr_uring_new(entries);
+    if (ring == NULL)
+    {
+        ASSERT(errno == ENOSYS || errno == EPERM);
+        printf("Skipping io_uring test, not supported.\n");
+    }
+
+    return ring;
+}
+
+/*
+ * A frame-connection through `ring` and a plain one for its peer,
+ * both non-blocking.
+ */
+static void new_uring_pair(mdr_uring_t* ring,
+                           mdr_frameconn_t** conn,
+                           mdr_frameconn_t** peer)
+{
+    int fds[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    make_nonblocking(fds[0]);
+    make_nonblocking(fds[1]);
+
+    mdr_transport_t* transport = mdr_uring_new_transport(ring, fds[0]);
+    ASSERT(transport != NULL);
+
+    *conn = mdr_frameconn_new_from_transport(transport);
+    *peer = mdr_frameconn_new_from_transport(mdr_transport_new_fd(fds[1]));
+    ASSERT(*conn != NULL && *peer != NULL);
+}
+
+static void test_uring_round_trip(void)
+{
+    mdr_uring_t* ring = new_test_ring(64);
+    if (ring == NULL) return;
+
+    mdr_frameconn_t* conn, *peer;
+    new_uring_pair(ring, &conn, &peer);
+
+    check_frame_round_trip(peer, conn, ring, 400);
+    check_frame_round_trip(conn, peer, ring, 400);
+
+    mdr_frameconn_close(conn);
+    mdr_frameconn_close(peer);
+    ASSERT(mdr_uring_submit(ring) == 0);
+    mdr_uring_free(ring);
+}
+
+/*
+ * Every peer sends `count` frames at once, which are echoed back by the
+ * connections through the ring. With more connections than `entries` the
+ * bursts produce more completions than the CQ of the ring holds.
+ */
+static void test_uring_burst(unsigned int entries, int connections, int count)
+{
+    mdr_uring_t* ring = new_test_ring(entries);
+    if (ring == NULL) return;
+
+    mdr_frameconn_t* conns[connections];
+    mdr_frameconn_t* peers[connections];
+    int echoed[connections];
+
+    for (int i = 0; i < connections; i++)
+    {
+        new_uring_pair(ring, &conns[i], &peers[i]);
+        echoed[i] = 0;
+
+        for (int n = 0; n < count; n++)
+        {
+            mdr_frame_t* frame = new_test_frame(n & 1, n);
+            ASSERT(mdr_frameconn_write_frame(peers[i], frame) == 0);
+            free(frame);
+        }
+    }
+
+    int done = 0;
+    for (int attempt = 0; attempt < MAX_ATTEMPTS && done < connections; attempt++)
+    {
+        pump_ring(ring);
+
+        for (int i = 0; i < connections; i++)
+        {
+            flush_write(peers[i]);
+
+            mdr_frame_t* frame;
+            while ((frame = mdr_frameconn_read_frame(conns[i])) != NULL)
+            {
+                ASSERT(mdr_frameconn_write_frame(conns[i], frame) == 0);
+                free(frame);
+            }
+            ASSERT(errno == EAGAIN || errno == EWOULDBLOCK);
+            flush_write(conns[i]);
+
+            while ((frame = mdr_frameconn_read_frame(peers[i])) != NULL)
+            {
+                ASSERT(test_frame_number(frame) == echoed[i]);
+                free(frame);
+
+                echoed[i]++;
+                if (echoed[i] == count) done++;
+            }
+            ASSERT(errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+
+    ASSERT(done == connections);
+
+    for (int i = 0; i < connections; i++)
+    {
+        mdr_frameconn_close(conns[i]);
+        mdr_frameconn_close(peers[i]);
+    }
+    ASSERT(mdr_uring_submit(ring) == 0);
+    mdr_uring_free(ring);
+}
+
+/*
+ * Writes larger than the socket buffer are sent in several parts, and
+ * writes made while a send is in flight are queued behind it.
+ */
+static void test_uring_partial_send(void)
+{
+    mdr_uring_t* ring = new_test_ring(8);
+    if (ring == NULL) return;
+
+    int fds[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    int sndbuf = 4096;
+    ASSERT(setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF,
+                      &sndbuf, sizeof(sndbuf)) == 0);
+    make_nonblocking(fds[0]);
+    make_nonblocking(fds[1]);
+
+    mdr_transport_t* transport = mdr_uring_new_transport(ring, fds[0]);
+    ASSERT(transport != NULL);
+
+    static uint8_t sent[60000], received[60000];
+    for (size_t i = 0; i < sizeof(sent); i++)
+    {
+        sent[i] = (i * 7 + i / 251) & 0xff;
+    }
+
+    for (size_t offset = 0; offset < sizeof(sent); offset += 20000)
+    {
+        struct iovec iov = { .iov_base = &sent[offset], .iov_len = 20000 };
+        ASSERT(mdr_transport_writev(transport, &iov, 1) == 20000);
+    }
+
+    // Only 64 KiB may be waiting to be sent.
+    struct iovec iov = { .iov_base = sent, .iov_len = 8192 };
+    ASSERT(mdr_transport_writev(transport, &iov, 1) == -1);
+    ASSERT(errno == EAGAIN);
+
+    size_t len = 0;
+    for (int attempt = 0; attempt < MAX_ATTEMPTS && len < sizeof(sent); attempt++)
+    {
+        ASSERT(mdr_uring_submit(ring) == 0);
+
+        ssize_t n = read(fds[1], &received[len], sizeof(received) - len);
+        if (n < 0)
+        {
+            ASSERT(errno == EAGAIN);
+            poll(NULL, 0, 1);
+        }
+        else
+        {
+            len += n;
+        }
+    }
+
+    ASSERT(len == sizeof(sent));
+    ASSERT(memcmp(sent, received, sizeof(sent)) == 0);
+
+    mdr_transport_close(transport);
+    close(fds[1]);
+    ASSERT(mdr_uring_submit(ring) == 0);
+    mdr_uring_free(ring);
+}
+
+static void test_uring_eof(void)
+{
+    mdr_uring_t* ring = new_test_ring(8);
+    if (ring == NULL) return;
+
+    mdr_frameconn_t* conn, *peer;
+    new_uring_pair(ring, &conn, &peer);
+
+    check_frame_round_trip(peer, conn, ring, 10);
+    mdr_frameconn_close(peer);
+
+    mdr_frame_t* frame = NULL;
+    int error = EAGAIN;
+    for (int attempt = 0; attempt < MAX_ATTEMPTS && error == EAGAIN; attempt++)
+    {
+        pump_ring(ring);
+
+        frame = mdr_frameconn_read_frame(conn);
+        error = errno;
+    }
+
+    ASSERT(frame == NULL);
+    ASSERT(error == MDR_E_CLOSED);
+
+    mdr_frameconn_close(conn);
+    ASSERT(mdr_uring_submit(ring) == 0);
+    mdr_uring_free(ring);
+}
+
+/*
+ * An event loop which blocks on the ring whenever no connection is
+ * waiting to read never stalls on input reaped into a transport.
+ */
+static void test_uring_buffered_input(void)
+{
+    mdr_uring_t* ring = new_test_ring(8);
+    if (ring == NULL) return;
+
+    mdr_frameconn_t* conn, *peer;
+    new_uring_pair(ring, &conn, &peer);
+
+    // Reads are never larger than 512 bytes, which the 16 byte frames
+    // divide, so some end exactly at a frame with more input received.
+    ASSERT(mdr_frameconn_set_buffer_limit(conn, 512) == 0);
+
+    int count = 200;
+    for (int i = 0; i < count; i++)
+    {
+        mdr_frame_t* frame = malloc(MDR_FRAME_EMPTY_LEN + 7);
+        ASSERT(frame != NULL);
+        frame->data_type = MDR_FRAME_DATA_TYPE_DATA_MDR;
+        frame->sequence_id = i & 1;
+        frame->payload_length = 7;
+        memset(mdr_frame_payload(frame), 1, 7);
+        *mdr_frame_checksum(frame) = mdr_frame_compute_checksum(frame);
+
+        ASSERT(mdr_frameconn_queue_frame(peer, frame) == 0);
+        free(frame);
+    }
+    ASSERT(mdr_frameconn_flush_write(peer) == 0);
+    ASSERT(mdr_uring_submit(ring) == 0);
+
+    int received = 0;
+    for (int attempt = 0; attempt < MAX_ATTEMPTS && received < count; attempt++)
+    {
+        // Waiting for a second stands in for -1,
+        // so a stall fails the test rather than hanging it.
+        int timeout = mdr_frameconn_waiting_read(conn) ? 0 : -1;
+        struct pollfd pfd = { .fd = mdr_uring_get_fd(ring), .events = POLLIN };
+        int ready = poll(&pfd, 1, timeout < 0 ? 1000 : timeout);
+        ASSERT(ready > 0 || timeout == 0);
+
+        mdr_frame_t* frame = mdr_frameconn_read_frame(conn);
+        if (frame != NULL)
+        {
+            ASSERT(frame->sequence_id == (received & 1));
+            free(frame);
+            received++;
+        }
+        else
+        {
+            ASSERT(errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+
+        ASSERT(mdr_uring_submit(ring) == 0);
+    }
+
+    ASSERT(received == count);
+
+    mdr_frameconn_close(conn);
+    mdr_frameconn_close(peer);
+    ASSERT(mdr_uring_submit(ring) == 0);
+    mdr_uring_free(ring);
+}
+
+/*
+ * Closing a transport cancels its receive, the socket is only released
+ * by the kernel once that has completed.
+ */
+static void test_uring_close_armed(void)
+{
+    mdr_uring_t* ring = new_test_ring(8);
+    if (ring == NULL) return;
+
+    int fds[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    make_nonblocking(fds[0]);
+
+    mdr_transport_t* transport = mdr_uring_new_transport(ring, fds[0]);
+    ASSERT(transport != NULL);
+    ASSERT(mdr_uring_submit(ring) == 0);
+
+    mdr_transport_close(transport);
+
+    ssize_t sent = 0;
+    for (int attempt = 0; attempt < MAX_ATTEMPTS && sent >= 0; attempt++)
+    {
+        pump_ring(ring);
+        sent = send(fds[1], "x", 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+    }
+
+    ASSERT(sent == -1);
+    ASSERT(errno == EPIPE);
+
+    close(fds[1]);
+    mdr_uring_free(ring);
+}
+
+/*
+ * Results and errors of the requests made by a test,
+ * requests are identified by their user data.
+ */
+#define MAX_TEST_REQUESTS 8
+
+static int request_results[MAX_TEST_REQUESTS];
+static int request_errors[MAX_TEST_REQUESTS];
+static int request_error_codes[MAX_TEST_REQUESTS];
+static int request_completion_order[MAX_TEST_REQUESTS];
+static int num_completed;
+
+static void reset_requests(void)
+{
+    memset(request_results, 0, sizeof(request_results));
+    memset(request_errors, 0, sizeof(request_errors));
+    memset(request_error_codes, 0, sizeof(request_error_codes));
+    num_completed = 0;
+}
+
+static void on_test_result(mdr_packet_t* packet, void* user_data)
+{
+    int id = (intptr_t) user_data;
+    request_results[id]++;
+    request_completion_order[num_completed++] = id;
+}
+
+static void on_test_error(void* user_data)
+{
+    int id = (intptr_t) user_data;
+    request_errors[id]++;
+    request_error_codes[id] = errno;
+}
+
+/*
+ * A packet-connection and a device on the other end of a loopback.
+ */
+typedef struct
+{
+    mdr_packetconn_t* conn;
+    mdr_frameconn_t* device;
+    uint8_t device_sequence_id;
+
+    // The packets received by the device,
+    // their type and last payload byte.
+    uint16_t received[MAX_TEST_REQUESTS];
+    int num_received;
+}
+test_device_t;
+
+static void new_test_device(test_device_t* device)
+{
+    mdr_transport_t* transports[2];
+    ASSERT(mdr_transport_new_loopback(transports) == 0);
+
+    device->conn = mdr_packetconn_new_from_frameconn(
+            mdr_frameconn_new_from_transport(transports[0]));
+    device->device = mdr_frameconn_new_from_transport(transports[1]);
+    ASSERT(device->conn != NULL && device->device != NULL);
+
+    device->device_sequence_id = 0;
+    device->num_received = 0;
+
+    reset_requests();
+}
+
+static void free_test_device(test_device_t* device)
+{
+    mdr_packetconn_close(device->conn);
+    mdr_frameconn_close(device->device);
+}
+
+/*
+ * A battery level packet sent by the device, with its next sequence id.
+ */
+static mdr_frame_t* new_battery_level_frame(test_device_t* device,
+                                            uint8_t inquired_type)
+{
+    mdr_packet_t packet = { .type = MDR_PACKET_COMMON_RET_BATTERY_LEVEL };
+    packet.data.common_ret_battery_level.inquired_type = inquired_type;
+
+    mdr_frame_t* frame = mdr_packet_to_frame(&packet);
+    ASSERT(frame != NULL);
+    frame->sequence_id = device->device_sequence_id;
+    *mdr_frame_checksum(frame) = mdr_frame_compute_checksum(frame);
+    device->device_sequence_id = !device->device_sequence_id;
+
+    return frame;
+}
+
+/*
+ * Process the connection and let the device receive what it sent,
+ * ACKing and replying to requests if `respond` is set.
+ */
+static void serve_test_device(test_device_t* device, bool respond)
+{
+    for (int i = 0; i < 20; i++)
+    {
+        if (mdr_packetconn_process(device->conn) < 0)
+        {
+            ASSERT(errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+
+        mdr_frame_t* frame;
+        while ((frame = mdr_frameconn_read_frame(device->device)) != NULL)
+        {
+            if (frame->data_type != MDR_FRAME_DATA_TYPE_DATA_MDR)
+            {
+                free(frame);
+                continue;
+            }
+
+            uint8_t* payload = mdr_frame_payload(frame);
+            ASSERT(device->num_received < MAX_TEST_REQUESTS);
+            device->received[device->num_received++]
+                    = payload[0] << 8 | payload[frame->payload_length - 1];
+
+            if (respond)
+            {
+                mdr_frame_t ack = {
+                    .data_type = MDR_FRAME_DATA_TYPE_ACK,
+                    .sequence_id = !frame->sequence_id,
+                    .payload_length = 0,
+                };
+                *mdr_frame_checksum(&ack) = mdr_frame_compute_checksum(&ack);
+                ASSERT(mdr_frameconn_write_frame(device->device, &ack) == 0);
+            }
+
+            if (respond && payload[0] == MDR_PACKET_COMMON_GET_BATTERY_LEVEL)
+            {
+                mdr_frame_t* reply_frame
+                        = new_battery_level_frame(device, payload[1]);
+                ASSERT(mdr_frameconn_write_frame(device->device,
+                                                 reply_frame) == 0);
+                free(reply_frame);
+            }
+
+            free(frame);
+        }
+    }
+}
+
+static void* get_battery_level(test_device_t* device,
+                               mdr_packet_battery_inquired_type_t type,
+                               int id)
+{
+    mdr_packet_t packet = { .type = MDR_PACKET_COMMON_GET_BATTERY_LEVEL };
+    packet.data.common_get_battery_level.inquired_type = type;
+
+    mdr_packetconn_reply_specifier_t reply = {
+        .packet_type = MDR_PACKET_COMMON_RET_BATTERY_LEVEL,
+        .extra = type,
+    };
+
+    void* handle = mdr_packetconn_make_request(device->conn,
+                                               &packet,
+                                               reply,
+                                               on_test_result,
+                                               on_test_error,
+                                               (void*) (intptr_t) id);
+    ASSERT(handle != NULL);
+    return handle;
+}
+
+static void set_vibrator(test_device_t* device, uint8_t value, int id)
+{
+    mdr_packet_t packet = { .type = MDR_PACKET_SYSTEM_SET_PARAM };
+    packet.data.system_set_param.inquired_type
+            = MDR_PACKET_SYSTEM_INQUIRED_TYPE_VIBRATOR;
+    packet.data.system_set_param.vibrator.setting_value = value;
+
+    mdr_packetconn_reply_specifier_t reply = { .only_ack = true };
+
+    ASSERT(mdr_packetconn_make_request(device->conn,
+                                       &packet,
+                                       reply,
+                                       on_test_result,
+                                       on_test_error,
+                                       (void*) (intptr_t) id) != NULL);
+}
+
+#define GET_BATTERY(type) \
+    (MDR_PACKET_COMMON_GET_BATTERY_LEVEL << 8 \
+     | MDR_PACKET_BATTERY_INQUIRED_TYPE_##type)
+#define SET_VIBRATOR(value) (MDR_PACKET_SYSTEM_SET_PARAM << 8 | (value))
+
+static void test_packetconn_coalesce_get(void)
+{
+    test_device_t device;
+    new_test_device(&device);
+
+    void* first = get_battery_level(&device,
+                                    MDR_PACKET_BATTERY_INQUIRED_TYPE_BATTERY,
+                                    0);
+    void* second = get_battery_level(&device,
+                                     MDR_PACKET_BATTERY_INQUIRED_TYPE_BATTERY,
+                                     1);
+    ASSERT(first == second);
+
+    serve_test_device(&device, true);
+
+    ASSERT(device.num_received == 1);
+    ASSERT(device.received[0] == GET_BATTERY(BATTERY));
+    ASSERT(request_results[0] == 1 && request_results[1] == 1);
+
+    free_test_device(&device);
+}
+
+static void test_packetconn_supersede_set(void)
+{
+    test_device_t device;
+    new_test_device(&device);
+
+    // A SET which has been sent is never superseded.
+    set_vibrator(&device, 1, 0);
+    mdr_packetconn_process(device.conn);
+    set_vibrator(&device, 2, 1);
+    ASSERT(request_errors[0] == 0);
+
+    serve_test_device(&device, true);
+    ASSERT(device.num_received == 2);
+    ASSERT(device.received[0] == SET_VIBRATOR(1));
+    ASSERT(device.received[1] == SET_VIBRATOR(2));
+    ASSERT(request_results[0] == 1 && request_results[1] == 1);
+
+    // A queued SET is replaced by a newer one, behind a GET being sent.
+    get_battery_level(&device, MDR_PACKET_BATTERY_INQUIRED_TYPE_BATTERY, 2);
+    mdr_packetconn_process(device.conn);
+    set_vibrator(&device, 3, 3);
+    set_vibrator(&device, 4, 4);
+    ASSERT(request_errors[3] == 1);
+    ASSERT(request_error_codes[3] == MDR_E_SUPERSEDED);
+    ASSERT(request_results[3] == 0);
+
+    serve_test_device(&device, true);
+    ASSERT(device.num_received == 4);
+    ASSERT(device.received[2] == GET_BATTERY(BATTERY));
+    ASSERT(device.received[3] == SET_VIBRATOR(4));
+    ASSERT(request_results[2] == 1 && request_results[4] == 1);
+    ASSERT(request_errors[2] == 0 && request_errors[4] == 0);
+    ASSERT(request_results[3] == 0 && request_errors[3] == 1);
+
+    free_test_device(&device);
+}
+
+static void test_packetconn_priority(void)
+{
+    test_device_t device;
+    new_test_device(&device);
+
+    ASSERT(mdr_packetconn_set_request_priority(device.conn, 3) == -1);
+    ASSERT(errno == EINVAL);
+
+    ASSERT(mdr_packetconn_set_request_priority(
+            device.conn, MDR_PACKETCONN_PRIORITY_BACKGROUND) == 0);
+    get_battery_level(&device, MDR_PACKET_BATTERY_INQUIRED_TYPE_BATTERY, 0);
+    mdr_packetconn_process(device.conn);
+    get_battery_level(&device,
+                      MDR_PACKET_BATTERY_INQUIRED_TYPE_LEFT_RIGHT_BATTERY,
+                      1);
+    get_battery_level(&device,
+                      MDR_PACKET_BATTERY_INQUIRED_TYPE_CRADLE_BATTERY,
+                      2);
+
+    // Overtakes the queued requests, not the one being sent.
+    ASSERT(mdr_packetconn_set_request_priority(
+            device.conn, MDR_PACKETCONN_PRIORITY_INTERACTIVE) == 0);
+    set_vibrator(&device, 1, 3);
+
+    serve_test_device(&device, true);
+
+    ASSERT(device.num_received == 4);
+    ASSERT(device.received[0] == GET_BATTERY(BATTERY));
+    ASSERT(device.received[1] == SET_VIBRATOR(1));
+    ASSERT(device.received[2] == GET_BATTERY(LEFT_RIGHT_BATTERY));
+    ASSERT(device.received[3] == GET_BATTERY(CRADLE_BATTERY));
+
+    ASSERT(num_completed == 4);
+    ASSERT(request_completion_order[0] == 0);
+    ASSERT(request_completion_order[1] == 3);
+    ASSERT(request_completion_order[2] == 1);
+    ASSERT(request_completion_order[3] == 2);
+
+    free_test_device(&device);
+}
+
+/*
+ * Frames left over by the frame budget are handled without the socket
+ * being readable again.
+ */
+static void test_packetconn_frame_budget(void)
+{
+    test_device_t device;
+    new_test_device(&device);
+
+    mdr_packetconn_reply_specifier_t spec = {
+        .packet_type = MDR_PACKET_COMMON_RET_BATTERY_LEVEL,
+        .extra = MDR_PACKET_BATTERY_INQUIRED_TYPE_BATTERY,
+    };
+    ASSERT(mdr_packetconn_subscribe(device.conn,
+                                    spec,
+                                    on_test_result,
+                                    (void*) (intptr_t) 0) != NULL);
+    ASSERT(mdr_packetconn_set_frame_budget(device.conn, 0) == -1);
+    ASSERT(mdr_packetconn_set_frame_budget(device.conn, 1) == 0);
+
+    // Sent in a single write, so they're all read at once.
+    for (int i = 0; i < 3; i++)
+    {
+        mdr_frame_t* frame = new_battery_level_frame(
+                &device, MDR_PACKET_BATTERY_INQUIRED_TYPE_BATTERY);
+        ASSERT(mdr_frameconn_queue_frame(device.device, frame) == 0);
+        free(frame);
+    }
+    ASSERT(mdr_frameconn_flush_write(device.device) == 0);
+
+    ASSERT(mdr_packetconn_process_by_availability(device.conn,
+                                                  true, false) == 0);
+    ASSERT(request_results[0] == 1);
+
+    for (int i = 2; i <= 3; i++)
+    {
+        ASSERT(mdr_packetconn_poll_info(device.conn).timeout == 0);
+        ASSERT(mdr_packetconn_process_by_availability(device.conn,
+                                                      false, false) == 0);
+        ASSERT(request_results[0] == i);
+    }
+
+    ASSERT(mdr_packetconn_poll_info(device.conn).timeout != 0);
+    ASSERT(mdr_packetconn_process_by_availability(device.conn,
+                                                  false, false) == 0);
+    ASSERT(request_results[0] == 3);
+
+    free_test_device(&device);
+}
+
+static void sleep_ms(int ms)
+{
+    struct timespec time = { ms / 1000, (ms % 1000) * 1000000 };
+    nanosleep(&time, NULL);
+}
+
+static int request_timeout(test_device_t* device)
+{
+    return mdr_packetconn_poll_info(device->conn).timeout;
+}
+
+static void test_packetconn_retransmit(void)
+{
+    test_device_t device;
+    new_test_device(&device);
+
+    // Nothing has been measured yet.
+    get_battery_level(&device, MDR_PACKET_BATTERY_INQUIRED_TYPE_BATTERY, 0);
+    mdr_packetconn_process(device.conn);
+    int timeout = request_timeout(&device);
+    ASSERT(timeout > 900 && timeout <= 1000);
+    serve_test_device(&device, true);
+    ASSERT(request_results[0] == 1);
+
+    // A fast round trip has been measured.
+    get_battery_level(&device, MDR_PACKET_BATTERY_INQUIRED_TYPE_BATTERY, 1);
+    mdr_packetconn_process(device.conn);
+    timeout = request_timeout(&device);
+    ASSERT(timeout > 150 && timeout <= 200);
+
+    // Sent again when not ACK'd, waiting twice as long.
+    serve_test_device(&device, false);
+    sleep_ms(timeout + 10);
+    mdr_packetconn_process(device.conn);
+    timeout = request_timeout(&device);
+    ASSERT(timeout > 350 && timeout <= 400);
+
+    // The slow ACK could be for either send and isn't measured.
+    sleep_ms(300);
+    serve_test_device(&device, true);
+    ASSERT(device.num_received == 3);
+    ASSERT(request_results[1] == 1);
+
+    get_battery_level(&device, MDR_PACKET_BATTERY_INQUIRED_TYPE_BATTERY, 2);
+    mdr_packetconn_process(device.conn);
+    timeout = request_timeout(&device);
+    ASSERT(timeout > 150 && timeout <= 200);
+    serve_test_device(&device, true);
+
+    // Gives up after the maximum number of tries.
+    ASSERT(mdr_packetconn_set_max_tries(device.conn, 0) == -1);
+    ASSERT(mdr_packetconn_set_max_tries(device.conn, 1) == 0);
+    ASSERT(mdr_packetconn_set_timeouts(device.conn, 20, 0) == 0);
+
+    get_battery_level(&device, MDR_PACKET_BATTERY_INQUIRED_TYPE_BATTERY, 3);
+    mdr_packetconn_process(device.conn);
+    timeout = request_timeout(&device);
+    ASSERT(timeout > 0 && timeout <= 20);
+    serve_test_device(&device, false);
+    sleep_ms(30);
+    mdr_packetconn_process(device.conn);
+    ASSERT(request_errors[3] == 1);
+    ASSERT(request_error_codes[3] == MDR_E_NO_ACK);
+
+    free_test_device(&device);
+}
+
+/*
+ * A decoded packet is a single block, even empty strings don't point
+ * outside of it.
+ */
+static void test_packet_from_frame_empty_string(void)
+{
+    mdr_packet_t packet = { .type = MDR_PACKET_CONNECT_RET_DEVICE_INFO };
+    packet.data.connect_ret_device_info.inquired_type
+            = MDR_PACKET_DEVICE_INFO_INQUIRED_TYPE_MODEL_NAME;
+    packet.data.connect_ret_device_info.model_name.len = 0;
+    packet.data.connect_ret_device_info.model_name.string = (uint8_t*) "";
+
+    mdr_frame_t* frame = mdr_packet_to_frame(&packet);
+    ASSERT(frame != NULL);
+
+    size_t size = mdr_packet_decoded_size(frame);
+    mdr_packet_t* decoded = mdr_packet_from_frame(frame);
+    ASSERT(decoded != NULL);
+
+    uint8_t* string = decoded->data.connect_ret_device_info.model_name.string;
+    ASSERT(decoded->data.connect_ret_device_info.model_name.len == 0);
+    ASSERT(string >= (uint8_t*) decoded
+           && string <= (uint8_t*) decoded + size);
+
+    mdr_packet_free(decoded);
+    free(frame);
+}
+
+/*
+ * The packet structs were laid out like their wire format, they are not
+ * anymore, run with --layout to check them anyway.
+ */
+static void test_packet_layout(void)
 {
     ASSERT_OFFSET(mdr_packet_t, data, 1);
 
@@ -133,7 +1066,6 @@ int main(int argc, char* argv[])
     ASSERT_OFFSET(mdr_packet_system_capability_assignable_settings_t, capability_keys, 1);
     ASSERT_OFFSET(mdr_packet_system_assignable_settings_capability_key_t, capability_presets, 4);
     ASSERT_OFFSET(mdr_packet_system_assignable_settings_capability_preset_t, capability_actions, 2);
-    ASSERT_SIZE(mdr_packet_system_assignable_settings_capability_caption_t, 2);
     ASSERT_SIZE(mdr_packet_system_get_param_t, 1);
     ASSERT_OFFSET(mdr_packet_system_ret_param_t, vibrator, 1);
     ASSERT_OFFSET(mdr_packet_system_ret_param_t, power_saving_mode, 1);
@@ -162,3 +1094,33 @@ int main(int argc, char* argv[])
     ASSERT_SIZE(mdr_packet_system_assignable_settings_preset_t, 1);
 }
 
+int main(int argc, char* argv[])
+{
+    test_packet_from_frame_empty_string();
+
+    test_frame_pool_release();
+    test_frameconn_fd();
+    test_frameconn_loopback();
+
+    test_uring_round_trip();
+    test_uring_burst(64, 1, 400);
+    test_uring_burst(1, 256, 50);
+    test_uring_partial_send();
+    test_uring_eof();
+    test_uring_buffered_input();
+    test_uring_close_armed();
+
+    test_packetconn_coalesce_get();
+    test_packetconn_supersede_set();
+    test_packetconn_priority();
+    test_packetconn_frame_budget();
+    test_packetconn_retransmit();
+
+    if (argc > 1 && strcmp(argv[1], "--layout") == 0)
+    {
+        test_packet_layout();
+    }
+
+    printf("All tests passed.\n");
+    return 0;
+}
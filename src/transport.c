@@ -0,0 +1,329 @@
+/*
+ * libmdr - MDR protocol library
+ *
+ *  Copyright (C) 2021 Andreas Olofsson
+ *
+ *
+ * This file is part of libmdr.
+ *
+ * libmdr is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libmdr is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libmdr. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "mdr/transport.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+
+struct mdr_transport
+{
+    const mdr_transport_ops_t* ops;
+    void* data;
+};
+
+mdr_transport_t* mdr_transport_new(const mdr_transport_ops_t* ops, void* data)
+{
+    mdr_transport_t* transport = malloc(sizeof(mdr_transport_t));
+    if (transport == NULL) return NULL;
+
+    transport->ops = ops;
+    transport->data = data;
+
+    return transport;
+}
+
+ssize_t mdr_transport_read(mdr_transport_t* transport, void* buf, size_t len)
+{
+    return transport->ops->read(transport->data, buf, len);
+}
+
+ssize_t mdr_transport_writev(mdr_transport_t* transport,
+                             const struct iovec* iov,
+                             int iovcnt)
+{
+    return transport->ops->writev(transport->data, iov, iovcnt);
+}
+
+int mdr_transport_poll_fd(mdr_transport_t* transport)
+{
+    return transport->ops->poll_fd(transport->data);
+}
+
+bool mdr_transport_has_buffered_input(mdr_transport_t* transport)
+{
+    if (transport->ops->has_buffered_input == NULL)
+    {
+        return false;
+    }
+
+    return transport->ops->has_buffered_input(transport->data);
+}
+
+void mdr_transport_close(mdr_transport_t* transport)
+{
+    transport->ops->close(transport->data);
+    free(transport);
+}
+
+void mdr_transport_free(mdr_transport_t* transport)
+{
+    if (transport->ops->free != NULL)
+    {
+        transport->ops->free(transport->data);
+    }
+    else
+    {
+        transport->ops->close(transport->data);
+    }
+    free(transport);
+}
+
+// File descriptor transport, the fd is stored in the data pointer itself.
+
+#define FD_FROM_DATA(data) ((int) (intptr_t) (data))
+
+static ssize_t fd_read(void* data, void* buf, size_t len)
+{
+    return read(FD_FROM_DATA(data), buf, len);
+}
+
+static ssize_t fd_writev(void* data, const struct iovec* iov, int iovcnt)
+{
+    return writev(FD_FROM_DATA(data), iov, iovcnt);
+}
+
+static int fd_poll_fd(void* data)
+{
+    return FD_FROM_DATA(data);
+}
+
+static void fd_close(void* data)
+{
+    close(FD_FROM_DATA(data));
+}
+
+static void fd_free(void* data)
+{
+    (void) data;
+}
+
+static const mdr_transport_ops_t fd_ops = {
+    .read = fd_read,
+    .writev = fd_writev,
+    .poll_fd = fd_poll_fd,
+    .has_buffered_input = NULL,
+    .close = fd_close,
+    .free = fd_free,
+};
+
+mdr_transport_t* mdr_transport_new_fd(int fd)
+{
+    return mdr_transport_new(&fd_ops, (void*) (intptr_t) fd);
+}
+
+int mdr_transport_new_socketpair(mdr_transport_t* transports[2])
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+    {
+        return -1;
+    }
+
+    transports[0] = mdr_transport_new_fd(fds[0]);
+    transports[1] = mdr_transport_new_fd(fds[1]);
+    if (transports[0] == NULL || transports[1] == NULL)
+    {
+        free(transports[0]);
+        free(transports[1]);
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    return 0;
+}
+
+// In-memory loopback transport.
+
+/*
+ * Bytes written in one direction which have not been read yet,
+ * [head, head + len) of `buf`.
+ */
+typedef struct
+{
+    uint8_t* buf;
+    size_t size;
+    size_t head;
+    size_t len;
+}
+loopback_queue_t;
+
+typedef struct
+{
+    // The queue read by each end, written by the other.
+    loopback_queue_t queues[2];
+    // Number of ends still open.
+    int open_ends;
+}
+loopback_t;
+
+typedef struct
+{
+    loopback_t* loopback;
+    int side;
+}
+loopback_end_t;
+
+static ssize_t loopback_read(void* data, void* buf, size_t len)
+{
+    loopback_end_t* end = data;
+    loopback_queue_t* queue = &end->loopback->queues[end->side];
+
+    if (queue->len == 0)
+    {
+        if (end->loopback->open_ends < 2)
+        {
+            return 0;
+        }
+
+        errno = EAGAIN;
+        return -1;
+    }
+
+    if (len > queue->len) len = queue->len;
+
+    memcpy(buf, &queue->buf[queue->head], len);
+    queue->head += len;
+    queue->len -= len;
+
+    if (queue->len == 0)
+    {
+        queue->head = 0;
+    }
+
+    return len;
+}
+
+static ssize_t loopback_writev(void* data, const struct iovec* iov, int iovcnt)
+{
+    loopback_end_t* end = data;
+    loopback_queue_t* queue = &end->loopback->queues[!end->side];
+
+    if (end->loopback->open_ends < 2)
+    {
+        errno = EPIPE;
+        return -1;
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        total += iov[i].iov_len;
+    }
+
+    if (queue->head > 0 && queue->head + queue->len + total > queue->size)
+    {
+        memmove(queue->buf, &queue->buf[queue->head], queue->len);
+        queue->head = 0;
+    }
+
+    if (queue->len + total > queue->size)
+    {
+        size_t size = queue->size > 0 ? queue->size : 1024;
+        while (size < queue->len + total) size <<= 1;
+
+        uint8_t* buf = realloc(queue->buf, size);
+        if (buf == NULL) return -1;
+
+        queue->buf = buf;
+        queue->size = size;
+    }
+
+    for (int i = 0; i < iovcnt; i++)
+    {
+        memcpy(&queue->buf[queue->head + queue->len],
+               iov[i].iov_base,
+               iov[i].iov_len);
+        queue->len += iov[i].iov_len;
+    }
+
+    return total;
+}
+
+static int loopback_poll_fd(void* data)
+{
+    (void) data;
+    return -1;
+}
+
+static void loopback_close(void* data)
+{
+    loopback_end_t* end = data;
+    loopback_t* loopback = end->loopback;
+
+    loopback->open_ends--;
+    if (loopback->open_ends == 0)
+    {
+        free(loopback->queues[0].buf);
+        free(loopback->queues[1].buf);
+        free(loopback);
+    }
+
+    free(end);
+}
+
+static const mdr_transport_ops_t loopback_ops = {
+    .read = loopback_read,
+    .writev = loopback_writev,
+    .poll_fd = loopback_poll_fd,
+    .has_buffered_input = NULL,
+    .close = loopback_close,
+    .free = NULL,
+};
+
+int mdr_transport_new_loopback(mdr_transport_t* transports[2])
+{
+    loopback_t* loopback = calloc(1, sizeof(loopback_t));
+    if (loopback == NULL) return -1;
+
+    loopback_end_t* ends[2];
+    ends[0] = malloc(sizeof(loopback_end_t));
+    ends[1] = malloc(sizeof(loopback_end_t));
+    transports[0] = mdr_transport_new(&loopback_ops, ends[0]);
+    transports[1] = mdr_transport_new(&loopback_ops, ends[1]);
+
+    if (ends[0] == NULL || ends[1] == NULL
+            || transports[0] == NULL || transports[1] == NULL)
+    {
+        free(ends[0]);
+        free(ends[1]);
+        free(transports[0]);
+        free(transports[1]);
+        free(loopback);
+        return -1;
+    }
+
+    for (int side = 0; side < 2; side++)
+    {
+        ends[side]->loopback = loopback;
+        ends[side]->side = side;
+    }
+    loopback->open_ends = 2;
+
+    return 0;
+}
@@ -0,0 +1,840 @@
+/*
+ * libmdr - MDR protocol library
+ *
+ *  Copyright (C) 2021 Andreas Olofsson
+ *
+ *
+ * This file is part of libmdr.
+ *
+ * libmdr is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libmdr is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libmdr. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "mdr/uring.h"
+
+#include <stdlib.h>
+#include <errno.h>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#endif
+
+#if defined(IORING_RECV_MULTISHOT)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+/*
+ * Received data lands in a ring of provided buffers shared by all
+ * transports of a ring, and is copied out as soon as it is reaped.
+ */
+#define URING_BUF_GROUP 0
+#define URING_BUF_COUNT 128
+#define URING_BUF_SIZE  2048
+
+/*
+ * Maximum number of bytes queued for sending per transport,
+ * writing more fails with EAGAIN until some have been sent.
+ */
+#define URING_MAX_QUEUED_SEND 65536
+
+/*
+ * The low bits of an operation's user data identify the operation,
+ * the rest is a pointer to the transport.
+ */
+#define URING_OP_RECV   0
+#define URING_OP_SEND   1
+#define URING_OP_CANCEL 2
+#define URING_OP_MASK   ((uint64_t) 3)
+
+typedef struct uring_transport uring_transport_t;
+
+/*
+ * A growable byte queue, [head, head + len) of `buf`.
+ */
+typedef struct
+{
+    uint8_t* buf;
+    size_t size;
+    size_t head;
+    size_t len;
+}
+byte_queue_t;
+
+struct uring_transport
+{
+    mdr_uring_t* ring;
+    int sock;
+
+    byte_queue_t received;
+    // Bytes handed to the kernel by the send in flight, never moved
+    // while it's in flight.
+    byte_queue_t sending;
+    // Bytes written while a send was in flight.
+    byte_queue_t queued;
+
+    bool recv_armed;
+    bool send_in_flight;
+    bool eof;
+    // Error reported by the kernel, as a positive errno value.
+    int error;
+
+    bool closed;
+
+    uring_transport_t* next;
+};
+
+struct mdr_uring
+{
+    int fd;
+
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+
+    unsigned int* sq_head;
+    unsigned int* sq_tail;
+    unsigned int* sq_mask;
+    unsigned int* sq_array;
+    unsigned int* sq_flags;
+    unsigned int sq_entries;
+    // Number of SQEs queued since the last submit.
+    unsigned int sq_pending;
+
+    unsigned int* cq_head;
+    unsigned int* cq_tail;
+    unsigned int* cq_mask;
+    struct io_uring_cqe* cqes;
+
+    struct io_uring_buf_ring* buf_ring;
+    size_t buf_ring_size;
+    uint8_t* bufs;
+
+    // Every transport which has not been freed yet.
+    uring_transport_t* transports;
+};
+
+static int io_uring_setup(unsigned int entries, struct io_uring_params* params)
+{
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int io_uring_enter(int fd,
+                          unsigned int to_submit,
+                          unsigned int min_complete,
+                          unsigned int flags)
+{
+    return syscall(__NR_io_uring_enter,
+                   fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int io_uring_register(int fd,
+                             unsigned int opcode,
+                             void* arg,
+                             unsigned int nr_args)
+{
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/*
+ * Hand buffer `bid` back to the kernel for receiving into.
+ */
+static void uring_recycle_buffer(mdr_uring_t* ring, uint16_t bid)
+{
+    uint16_t tail = ring->buf_ring->tail;
+    struct io_uring_buf* buf =
+        &ring->buf_ring->bufs[tail & (URING_BUF_COUNT - 1)];
+
+    buf->addr = (uint64_t) (uintptr_t) &ring->bufs[bid * URING_BUF_SIZE];
+    buf->len = URING_BUF_SIZE;
+    buf->bid = bid;
+
+    __atomic_store_n(&ring->buf_ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Check if completions didn't fit in the CQ and are held by the kernel
+ * until there is room, only entering the ring to get events moves them.
+ */
+static bool uring_cq_overflowed(mdr_uring_t* ring)
+{
+    return __atomic_load_n(ring->sq_flags, __ATOMIC_ACQUIRE)
+         & IORING_SQ_CQ_OVERFLOW;
+}
+
+/*
+ * Enter the ring without submitting anything to flush any overflowed
+ * completions into the CQ.
+ *
+ * Returns 0 on success, returns -1 and sets errno on error.
+ */
+static int uring_get_events(mdr_uring_t* ring)
+{
+    while (io_uring_enter(ring->fd, 0, 0, IORING_ENTER_GETEVENTS) < 0)
+    {
+        if (errno == EINTR) continue;
+        // The CQ is still full of completions which haven't been reaped.
+        if (errno == EBUSY) return 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+static int uring_flush_submissions(mdr_uring_t* ring)
+{
+    while (ring->sq_pending > 0)
+    {
+        int submitted = io_uring_enter(ring->fd, ring->sq_pending, 0, 0);
+        if (submitted < 0)
+        {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+
+        ring->sq_pending -= submitted;
+    }
+
+    return 0;
+}
+
+/*
+ * Get an SQE to fill in, submitting queued ones if the queue is full.
+ *
+ * Returns NULL and sets errno on error.
+ */
+static struct io_uring_sqe* uring_get_sqe(mdr_uring_t* ring)
+{
+    unsigned int head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    unsigned int tail = *ring->sq_tail;
+
+    if (tail - head >= ring->sq_entries)
+    {
+        if (uring_flush_submissions(ring) < 0) return NULL;
+
+        head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (tail - head >= ring->sq_entries)
+        {
+            errno = EBUSY;
+            return NULL;
+        }
+    }
+
+    unsigned int index = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->sq_pending++;
+
+    return sqe;
+}
+
+static uint64_t uring_user_data(uring_transport_t* transport, uint64_t op)
+{
+    return (uint64_t) (uintptr_t) transport | op;
+}
+
+static int uring_arm_recv(uring_transport_t* transport)
+{
+    struct io_uring_sqe* sqe = uring_get_sqe(transport->ring);
+    if (sqe == NULL) return -1;
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = transport->sock;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUF_GROUP;
+    sqe->user_data = uring_user_data(transport, URING_OP_RECV);
+
+    transport->recv_armed = true;
+    return 0;
+}
+
+static int uring_start_send(uring_transport_t* transport)
+{
+    struct io_uring_sqe* sqe = uring_get_sqe(transport->ring);
+    if (sqe == NULL) return -1;
+
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = transport->sock;
+    sqe->addr = (uint64_t) (uintptr_t)
+            &transport->sending.buf[transport->sending.head];
+    sqe->len = transport->sending.len;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = uring_user_data(transport, URING_OP_SEND);
+
+    transport->send_in_flight = true;
+    return 0;
+}
+
+/*
+ * Append `len` bytes to a byte queue, growing it as needed.
+ *
+ * Returns 0 on success, returns -1 and sets errno on error.
+ */
+static int byte_queue_push(byte_queue_t* queue, const void* bytes, size_t len)
+{
+    if (queue->head > 0 && queue->head + queue->len + len > queue->size)
+    {
+        memmove(queue->buf, &queue->buf[queue->head], queue->len);
+        queue->head = 0;
+    }
+
+    if (queue->len + len > queue->size)
+    {
+        size_t size = queue->size > 0 ? queue->size : URING_BUF_SIZE;
+        while (size < queue->len + len) size <<= 1;
+
+        uint8_t* buf = realloc(queue->buf, size);
+        if (buf == NULL) return -1;
+
+        queue->buf = buf;
+        queue->size = size;
+    }
+
+    memcpy(&queue->buf[queue->head + queue->len], bytes, len);
+    queue->len += len;
+
+    return 0;
+}
+
+static void byte_queue_pop(byte_queue_t* queue, size_t len)
+{
+    queue->head += len;
+    queue->len -= len;
+
+    if (queue->len == 0)
+    {
+        queue->head = 0;
+    }
+}
+
+static void uring_transport_destroy(uring_transport_t* transport)
+{
+    mdr_uring_t* ring = transport->ring;
+
+    for (uring_transport_t** t = &ring->transports; *t != NULL; t = &(*t)->next)
+    {
+        if (*t == transport)
+        {
+            *t = transport->next;
+            break;
+        }
+    }
+
+    free(transport->received.buf);
+    free(transport->sending.buf);
+    free(transport->queued.buf);
+    free(transport);
+}
+
+static void uring_handle_recv(uring_transport_t* transport,
+                              struct io_uring_cqe* cqe)
+{
+    mdr_uring_t* ring = transport->ring;
+
+    if (cqe->flags & IORING_CQE_F_BUFFER)
+    {
+        uint16_t bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+
+        if (cqe->res > 0 && !transport->closed)
+        {
+            if (byte_queue_push(&transport->received,
+                                &ring->bufs[bid * URING_BUF_SIZE],
+                                cqe->res) < 0)
+            {
+                transport->error = errno;
+            }
+        }
+
+        uring_recycle_buffer(ring, bid);
+    }
+
+    if (cqe->res == 0)
+    {
+        transport->eof = true;
+    }
+    else if (cqe->res < 0 && cqe->res != -ENOBUFS)
+    {
+        transport->error = -cqe->res;
+    }
+
+    if (!(cqe->flags & IORING_CQE_F_MORE))
+    {
+        transport->recv_armed = false;
+
+        // Re-arm unless the socket is done, e.g. after running out of
+        // buffers, they've all been recycled again at this point.
+        if (!transport->closed
+                && !transport->eof
+                && transport->error == 0)
+        {
+            if (uring_arm_recv(transport) < 0)
+            {
+                transport->error = errno;
+            }
+        }
+    }
+}
+
+static void uring_handle_send(uring_transport_t* transport,
+                              struct io_uring_cqe* cqe)
+{
+    transport->send_in_flight = false;
+
+    if (cqe->res < 0)
+    {
+        transport->error = -cqe->res;
+        return;
+    }
+
+    byte_queue_pop(&transport->sending, cqe->res);
+
+    if (transport->closed) return;
+
+    if (transport->sending.len == 0 && transport->queued.len > 0)
+    {
+        byte_queue_t sending = transport->sending;
+        transport->sending = transport->queued;
+        transport->queued = sending;
+    }
+
+    if (transport->sending.len > 0)
+    {
+        if (uring_start_send(transport) < 0)
+        {
+            transport->error = errno;
+        }
+    }
+}
+
+/*
+ * Handle every available completion, this does not make any system call.
+ */
+static void uring_reap(mdr_uring_t* ring)
+{
+    unsigned int head = *ring->cq_head;
+
+    while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+    {
+        struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+
+        uint64_t op = cqe->user_data & URING_OP_MASK;
+        uring_transport_t* transport = (uring_transport_t*) (uintptr_t)
+                (cqe->user_data & ~URING_OP_MASK);
+
+        switch (op)
+        {
+            case URING_OP_RECV:
+                uring_handle_recv(transport, cqe);
+                break;
+
+            case URING_OP_SEND:
+                uring_handle_send(transport, cqe);
+                break;
+
+            default:
+                break;
+        }
+
+        if (op != URING_OP_CANCEL
+                && transport->closed
+                && !transport->recv_armed
+                && !transport->send_in_flight)
+        {
+            uring_transport_destroy(transport);
+        }
+
+        head++;
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+}
+
+static ssize_t uring_transport_read(void* data, void* buf, size_t len)
+{
+    uring_transport_t* transport = data;
+
+    uring_reap(transport->ring);
+
+    if (transport->received.len > 0)
+    {
+        if (len > transport->received.len) len = transport->received.len;
+
+        memcpy(buf,
+               &transport->received.buf[transport->received.head],
+               len);
+        byte_queue_pop(&transport->received, len);
+
+        return len;
+    }
+
+    if (transport->error != 0)
+    {
+        errno = transport->error;
+        return -1;
+    }
+
+    if (transport->eof)
+    {
+        return 0;
+    }
+
+    errno = EAGAIN;
+    return -1;
+}
+
+static ssize_t uring_transport_writev(void* data,
+                                      const struct iovec* iov,
+                                      int iovcnt)
+{
+    uring_transport_t* transport = data;
+
+    uring_reap(transport->ring);
+
+    if (transport->error != 0)
+    {
+        errno = transport->error;
+        return -1;
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        total += iov[i].iov_len;
+    }
+
+    if (transport->sending.len + transport->queued.len + total
+            > URING_MAX_QUEUED_SEND)
+    {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    byte_queue_t* queue = transport->send_in_flight
+            ? &transport->queued
+            : &transport->sending;
+
+    for (int i = 0; i < iovcnt; i++)
+    {
+        if (byte_queue_push(queue, iov[i].iov_base, iov[i].iov_len) < 0)
+        {
+            return -1;
+        }
+    }
+
+    if (!transport->send_in_flight && transport->sending.len > 0)
+    {
+        if (uring_start_send(transport) < 0)
+        {
+            return -1;
+        }
+    }
+
+    return total;
+}
+
+static int uring_transport_poll_fd(void* data)
+{
+    uring_transport_t* transport = data;
+    return transport->ring->fd;
+}
+
+static bool uring_transport_has_buffered_input(void* data)
+{
+    uring_transport_t* transport = data;
+
+    // Completions are reaped for every transport of the ring at once,
+    // so the ring fd stays quiet for what they left here.
+    return transport->received.len > 0
+        || transport->eof
+        || transport->error != 0;
+}
+
+static void uring_transport_close(void* data)
+{
+    uring_transport_t* transport = data;
+
+    transport->closed = true;
+
+    if (transport->recv_armed)
+    {
+        struct io_uring_sqe* sqe = uring_get_sqe(transport->ring);
+        if (sqe != NULL)
+        {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = uring_user_data(transport, URING_OP_RECV);
+            sqe->user_data = uring_user_data(transport, URING_OP_CANCEL);
+        }
+    }
+
+    // The ring holds its own reference to the socket
+    // while operations are in flight.
+    close(transport->sock);
+
+    if (!transport->recv_armed && !transport->send_in_flight)
+    {
+        uring_transport_destroy(transport);
+    }
+}
+
+static const mdr_transport_ops_t uring_transport_ops = {
+    .read = uring_transport_read,
+    .writev = uring_transport_writev,
+    .poll_fd = uring_transport_poll_fd,
+    .has_buffered_input = uring_transport_has_buffered_input,
+    .close = uring_transport_close,
+    .free = NULL,
+};
+
+mdr_uring_t* mdr_uring_new(unsigned int entries)
+{
+    mdr_uring_t* ring = calloc(1, sizeof(mdr_uring_t));
+    if (ring == NULL) return NULL;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(struct io_uring_params));
+
+    // Every buffer may be holding a received chunk while each transport
+    // also completes a receive, a send and a cancellation.
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = URING_BUF_COUNT + 3 * entries;
+
+    ring->fd = io_uring_setup(entries, &params);
+    if (ring->fd < 0)
+    {
+        free(ring);
+        return NULL;
+    }
+
+    ring->sq_ring_size = params.sq_off.array
+                       + params.sq_entries * sizeof(unsigned int);
+    ring->cq_ring_size = params.cq_off.cqes
+                       + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (ring->cq_ring_size > ring->sq_ring_size)
+            ring->sq_ring_size = ring->cq_ring_size;
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size,
+                         PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) goto error;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        ring->cq_ring = ring->sq_ring;
+    }
+    else
+    {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size,
+                             PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) goto error;
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size,
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) goto error;
+
+    uint8_t* sq = ring->sq_ring;
+    ring->sq_head = (unsigned int*) (sq + params.sq_off.head);
+    ring->sq_tail = (unsigned int*) (sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned int*) (sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned int*) (sq + params.sq_off.array);
+    ring->sq_flags = (unsigned int*) (sq + params.sq_off.flags);
+    ring->sq_entries = params.sq_entries;
+
+    uint8_t* cq = ring->cq_ring;
+    ring->cq_head = (unsigned int*) (cq + params.cq_off.head);
+    ring->cq_tail = (unsigned int*) (cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned int*) (cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*) (cq + params.cq_off.cqes);
+
+    ring->buf_ring_size = URING_BUF_COUNT * sizeof(struct io_uring_buf);
+    ring->buf_ring = mmap(NULL, ring->buf_ring_size,
+                          PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                          -1, 0);
+    if (ring->buf_ring == MAP_FAILED) goto error;
+
+    ring->bufs = malloc(URING_BUF_COUNT * URING_BUF_SIZE);
+    if (ring->bufs == NULL) goto error;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(struct io_uring_buf_reg));
+    reg.ring_addr = (uint64_t) (uintptr_t) ring->buf_ring;
+    reg.ring_entries = URING_BUF_COUNT;
+    reg.bgid = URING_BUF_GROUP;
+    if (io_uring_register(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        goto error;
+    }
+
+    for (uint16_t bid = 0; bid < URING_BUF_COUNT; bid++)
+    {
+        uring_recycle_buffer(ring, bid);
+    }
+
+    return ring;
+
+error:
+    {
+        int error = errno;
+        mdr_uring_free(ring);
+        errno = error;
+    }
+    return NULL;
+}
+
+void mdr_uring_free(mdr_uring_t* ring)
+{
+    // Closing the ring cancels everything still in flight.
+    if (ring->fd >= 0) close(ring->fd);
+
+    uring_transport_t* next = NULL;
+    for (uring_transport_t* transport = ring->transports;
+         transport != NULL;
+         transport = next)
+    {
+        next = transport->next;
+
+        free(transport->received.buf);
+        free(transport->sending.buf);
+        free(transport->queued.buf);
+        free(transport);
+    }
+
+    if (ring->sq_ring != NULL && ring->sq_ring != MAP_FAILED)
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    if (ring->cq_ring != NULL && ring->cq_ring != MAP_FAILED
+            && ring->cq_ring != ring->sq_ring)
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    if (ring->sqes != NULL && ring->sqes != MAP_FAILED)
+        munmap(ring->sqes, ring->sqes_size);
+    if (ring->buf_ring != NULL && ring->buf_ring != MAP_FAILED)
+        munmap(ring->buf_ring, ring->buf_ring_size);
+
+    free(ring->bufs);
+    free(ring);
+}
+
+int mdr_uring_get_fd(mdr_uring_t* ring)
+{
+    return ring->fd;
+}
+
+int mdr_uring_submit(mdr_uring_t* ring)
+{
+    // Submitting enters the ring, otherwise enter it anyway to pick up
+    // completions held back by the kernel.
+    bool get_events = ring->sq_pending == 0;
+
+    if (uring_flush_submissions(ring) < 0) return -1;
+
+    do
+    {
+        if (get_events || uring_cq_overflowed(ring))
+        {
+            if (uring_get_events(ring) < 0) return -1;
+        }
+        get_events = false;
+
+        uring_reap(ring);
+
+        // Handling completions may have queued more operations,
+        // e.g. the rest of a partial send or a re-armed receive.
+        if (uring_flush_submissions(ring) < 0) return -1;
+    }
+    while (uring_cq_overflowed(ring));
+
+    return 0;
+}
+
+mdr_transport_t* mdr_uring_new_transport(mdr_uring_t* ring, int sock)
+{
+    uring_transport_t* transport = calloc(1, sizeof(uring_transport_t));
+    if (transport == NULL) return NULL;
+
+    transport->ring = ring;
+    transport->sock = sock;
+
+    mdr_transport_t* wrapper = mdr_transport_new(&uring_transport_ops,
+                                                 transport);
+    if (wrapper == NULL)
+    {
+        free(transport);
+        return NULL;
+    }
+
+    if (uring_arm_recv(transport) < 0)
+    {
+        free(wrapper);
+        free(transport);
+        return NULL;
+    }
+
+    transport->next = ring->transports;
+    ring->transports = transport;
+
+    return wrapper;
+}
+
+#else /* IORING_RECV_MULTISHOT */
+
+mdr_uring_t* mdr_uring_new(unsigned int entries)
+{
+    (void) entries;
+    errno = ENOSYS;
+    return NULL;
+}
+
+void mdr_uring_free(mdr_uring_t* ring)
+{
+    (void) ring;
+}
+
+int mdr_uring_get_fd(mdr_uring_t* ring)
+{
+    (void) ring;
+    return -1;
+}
+
+int mdr_uring_submit(mdr_uring_t* ring)
+{
+    (void) ring;
+    errno = ENOSYS;
+    return -1;
+}
+
+mdr_transport_t* mdr_uring_new_transport(mdr_uring_t* ring, int sock)
+{
+    (void) ring;
+    (void) sock;
+    errno = ENOSYS;
+    return NULL;
+}
+
+#endif /* IORING_RECV_MULTISHOT */